@@ -0,0 +1,157 @@
+/**
+    Copyright (c) 2024, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+/* affinity benchmark
+   throughput of a pxi pool with its worker threads left to the scheduler and pinned with each of the affinity modes;
+   every queue sums a buffer of its own, over and over, and the buffer is first touched by the queue's worker, so that
+   it is placed on the node the worker happened to run on at the time: unpinned workers that later migrate, across
+   cores or sockets, pay for cold caches and remote memory. The last mode places all the queues on the node of a
+   buffer made by the main thread, with set_affinity_near(), and has them all sum that buffer.
+   Differences only show on machines with several cores, and remote memory only on several NUMA nodes.
+   usage: bench_affinity [queues] [buffer size in KB] [tasks per queue] [rounds]
+*/
+#include <pxi.h>
+#include <pxi/pool.h>
+#include <pxi/topology.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static constexpr int queue_max = 64;
+
+static int         s_queue_count = 4;
+static std::size_t s_buffer_size = 256;
+static int         s_task_count = 1000;
+static int         s_round_count = 3;
+
+static std::atomic<long> s_sum;
+
+/* slot
+   buffer of a queue, allocated by the first task that runs on it
+*/
+struct slot {
+  std::vector<long>  data;
+  const std::vector<long>* shared;
+};
+
+struct job {
+  slot*   buffer;
+
+  public:
+  inline  void operator()() noexcept {
+          const std::vector<long>* l_data = buffer->shared;
+          long l_sum = 0;
+          if(l_data == nullptr) {
+              if(buffer->data.empty()) {
+                  buffer->data.resize(s_buffer_size * 1024 / sizeof(long), 1);
+              }
+              l_data = std::addressof(buffer->data);
+          }
+          for(long i_value : *l_data) {
+              l_sum += i_value;
+          }
+          s_sum.fetch_add(l_sum, std::memory_order_relaxed);
+  }
+};
+
+static void run(const char* name, int mode, bool near) noexcept
+{
+      std::vector<long> l_shared;
+      std::vector<slot> l_slot_list(s_queue_count);
+      double            l_time = 0.0;
+      if(near) {
+          l_shared.resize(s_buffer_size * 1024 / sizeof(long), 1);
+          for(auto& i_slot : l_slot_list) {
+              i_slot.shared = std::addressof(l_shared);
+          }
+      } else {
+          for(auto& i_slot : l_slot_list) {
+              i_slot.shared = nullptr;
+          }
+      }
+      pxi::pool<job, std::thread, queue_max, pxi_policy_fast> l_pool(s_queue_count);
+      bool  l_result;
+      if(near) {
+          l_result = l_pool.set_affinity_near(l_shared.data(), mode);
+      } else
+          l_result = l_pool.set_affinity(mode);
+      for(int i_round = 0; i_round <= s_round_count; i_round++) {
+          auto  l_time_0 = std::chrono::steady_clock::now();
+          for(int i_task = 0; i_task < s_task_count; i_task++) {
+              for(int i_queue = 0; i_queue < s_queue_count; i_queue++) {
+                  l_pool.schedule_explicit(i_queue, job{std::addressof(l_slot_list[i_queue])});
+              }
+          }
+          for(int i_queue = 0; i_queue < s_queue_count; i_queue++) {
+              while(l_pool[i_queue].count()) {
+                  std::this_thread::sleep_for(std::chrono::microseconds(100));
+              }
+          }
+          auto  l_time_1 = std::chrono::steady_clock::now();
+          // the first round warms up: threads start and the buffers get allocated
+          if(i_round) {
+              l_time += std::chrono::duration<double>(l_time_1 - l_time_0).count();
+          }
+      }
+      double l_rate = static_cast<double>(s_task_count) * s_queue_count * s_round_count / l_time;
+      std::printf("%-24s %10.0f tasks/s  %8.3f ms/round%s\n", name, l_rate, l_time * 1000.0 / s_round_count, l_result ? "" : "  (set_affinity failed)");
+}
+
+int   main(int argc, char** argv)
+{
+      const pxi::topology& l_topology = pxi::topology::get_default();
+      if(argc > 1) {
+          s_queue_count = std::atoi(argv[1]);
+      } else
+          s_queue_count = l_topology.get_cpu_count();
+      if(s_queue_count < 2) {
+          s_queue_count = 2;
+      }
+      if(s_queue_count > queue_max) {
+          s_queue_count = queue_max;
+      }
+      if(argc > 2) {
+          s_buffer_size = std::strtoul(argv[2], nullptr, 10);
+      }
+      if(argc > 3) {
+          s_task_count = std::atoi(argv[3]);
+      }
+      if(argc > 4) {
+          s_round_count = std::atoi(argv[4]);
+      }
+      std::printf(
+          "%d cpus on %d nodes; %d queues, %zu KB per queue, %d tasks per queue and round, %d rounds\n",
+          l_topology.get_cpu_count(),
+          l_topology.get_node_count(),
+          s_queue_count,
+          s_buffer_size,
+          s_task_count,
+          s_round_count
+      );
+      run("pxi_affinity_none", pxi_affinity_none, false);
+      run("pxi_affinity_core", pxi_affinity_core, false);
+      run("pxi_affinity_node", pxi_affinity_node, false);
+      run("set_affinity_near (node)", pxi_affinity_node, true);
+      return 0;
+}
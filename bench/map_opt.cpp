@@ -0,0 +1,98 @@
+/**
+    Copyright (c) 2024, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+/* map_opt benchmark
+   fill a 256MB mmi::pool<std::uint64_t> one node at a time, then read it back at random, with the pool backed by the
+   map resource and by map_opt with each of its options; reports the times and how much of the process is backed by
+   transparent huge pages, as seen in /proc/self/smaps_rollup
+   usage: bench_map_opt [size in MB] [random reads in millions]
+*/
+#include <mmi.h>
+#include <mmi/pool.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+static std::size_t s_pool_size = 256u << 20;
+static std::size_t s_read_count = 20000000u;
+
+static long int get_huge_size() noexcept
+{
+      long int l_size = 0;
+      char     l_line[256];
+      FILE*    l_file = std::fopen("/proc/self/smaps_rollup", "r");
+      if(l_file != nullptr) {
+          while(std::fgets(l_line, sizeof(l_line), l_file) != nullptr) {
+              std::sscanf(l_line, "AnonHugePages: %ld", std::addressof(l_size));
+          }
+          std::fclose(l_file);
+      }
+      return l_size;
+}
+
+template<typename Rt>
+static void run(const char* name) noexcept
+{
+      std::size_t    l_count = s_pool_size / sizeof(std::uint64_t);
+      std::uint64_t  l_seed = 12345;
+      std::uint64_t  l_sum = 0;
+      auto           l_time_0 = std::chrono::steady_clock::now();
+      mmi::pool<std::uint64_t, Rt> l_pool;
+      if(l_pool.reserve(l_count) == false) {
+          std::printf("%-32s reserve failed\n", name);
+          return;
+      }
+      for(std::size_t i_node = 0; i_node < l_count; i_node++) {
+          *l_pool.raw_get() = i_node;
+      }
+      auto           l_time_1 = std::chrono::steady_clock::now();
+      std::uint64_t* l_base = l_pool.at(0);
+      for(std::size_t i_read = 0; i_read < s_read_count; i_read++) {
+          l_seed = l_seed * 6364136223846793005ull + 1442695040888963407ull;
+          l_sum += l_base[(l_seed >> 20) % l_count];
+      }
+      auto           l_time_2 = std::chrono::steady_clock::now();
+      std::printf(
+          "%-32s fill %.3fs  random %.3fs  AnonHugePages %ldK  (%lu)\n",
+          name,
+          std::chrono::duration<double>(l_time_1 - l_time_0).count(),
+          std::chrono::duration<double>(l_time_2 - l_time_1).count(),
+          get_huge_size(),
+          static_cast<unsigned long>(l_sum & 1)
+      );
+}
+
+int   main(int argc, char** argv)
+{
+      if(argc > 1) {
+          s_pool_size = std::strtoul(argv[1], nullptr, 10) << 20;
+      }
+      if(argc > 2) {
+          s_read_count = std::strtoul(argv[2], nullptr, 10) * 1000000u;
+      }
+      run<map>("map (4K)");
+      run<map_opt<map::opt_huge_auto>>("map_opt<huge_auto>");
+      run<map_opt<map::opt_huge_page>>("map_opt<huge_page>");
+      run<map_opt<map::opt_huge_auto | map::opt_populate>>("map_opt<huge_auto|populate>");
+      run<map_opt<map::opt_huge_auto | map::opt_populate, 0>>("map_opt<huge_auto|populate, 0>");
+      return 0;
+}
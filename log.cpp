@@ -23,6 +23,7 @@
 #include <time.h>
 #include <stdio.h>
 #include "dbg.h"
+#include "tmp.h"
 
 static FILE*  g_log_aux = nullptr;
 
@@ -41,14 +42,29 @@ void  vprintlog(const char* message, const char* file, int line, va_list va_out)
       } else
           p_log_out = stdout;
       if(g_log_aux != nullptr) {
+          // format the message once in the scratch arena and write it to both outputs
+          tmp::scope l_scope;
           va_copy(va_aux, va_out);
-          fprintf(g_log_aux, "%.8lx| ", time(nullptr));
-          vfprintf(g_log_aux, message, va_aux);
-          fprintf(g_log_aux, "\n");
-          fflush(g_log_aux);
+          const char* l_text = tmp::ptr_fmt_v(message, va_aux);
+          va_end(va_aux);
+          if(l_text != nullptr) {
+              fprintf(g_log_aux, "%.8lx| %s\n", time(nullptr), l_text);
+              fflush(g_log_aux);
+              fprintf(p_log_out, "%s\n", l_text);
+          } else {
+              va_copy(va_aux, va_out);
+              fprintf(g_log_aux, "%.8lx| ", time(nullptr));
+              vfprintf(g_log_aux, message, va_aux);
+              fprintf(g_log_aux, "\n");
+              fflush(g_log_aux);
+              va_end(va_aux);
+              vfprintf(p_log_out, message, va_out);
+              fprintf(p_log_out, "\n");
+          }
+      } else {
+          vfprintf(p_log_out, message, va_out);
+          fprintf(p_log_out, "\n");
       }
-      vfprintf(p_log_out, message, va_out);
-      fprintf(p_log_out, "\n");
 #ifndef NDEBUG
       if(file != nullptr) {
           if(l_tag_error) {
@@ -43,5 +43,13 @@ class page;
 template<typename Xt, std::size_t PageSize = 256, std::size_t ArraySize = 1, typename Rt = heap>
 class bank;
 
+template<typename Xt, std::size_t PageSize = 256, std::size_t ArraySize = 1, typename Rt = heap>
+class slab;
+
+/* get_thread_slot()
+   small, stable number identifying the calling thread; used to spread per-thread state across fixed size tables
+*/
+unsigned int get_thread_slot() noexcept;
+
 /*namespace mmi*/ }
 #endif
@@ -47,14 +47,134 @@ class bank: public page<Xt, get_div_ub(PageSize, 8), ArraySize, Rt>
   node_type*    m_page_pos;
   unsigned int  m_page_count;
   unsigned int  m_page_max;
+  std::size_t   m_page_mask;  /*if pages are aligned, mask to apply to a node address to find its page memory*/
+  page_type*    m_page_last;
+  unsigned int  m_page_idle;  /*number of empty pages that still hold on to their memory*/
+  unsigned int  m_page_spare; /*number of idle pages to keep around when trimming*/
+  unsigned int  m_page_trim;  /*number of idle pages above m_page_spare that triggers an automatic trim()*/
+
+  private:
+  /* get_free_node()
+     find a free slot, starting with the current page and adding a new page if all the others are full;
+     the page owning the slot is returned through <page>
+  */
+          node_type* get_free_node(page_type*& page) noexcept {
+          page_type* l_page_iter = m_page_iter;
+          bool       l_page_wrap = m_page_iter != get_root_page();
+          while(l_page_iter) {
+              // full pages are skipped without looking at their maps
+              if(l_page_iter->has_free()) {
+                  if(node_type* l_result = l_page_iter->find(nullptr, m_page_pos); l_result) {
+                      if(l_page_iter->is_empty()) {
+                          if(l_page_iter->m_map_cold) {
+                              l_page_iter->m_map_cold = false;
+                          } else
+                              m_page_idle--;
+                      }
+                      m_page_iter = l_page_iter;
+                      page = l_page_iter;
+                      return l_result;
+                  }
+              }
+              auto l_page_next = l_page_iter->get_next_page();
+              if(l_page_next == nullptr) {
+                  // reached the last page: give the pages before the starting point a chance before growing
+                  if(l_page_wrap) {
+                      l_page_next = get_root_page();
+                      l_page_wrap = false;
+                  } else
+                  if(m_page_count < m_page_max) {
+                      l_page_next = l_page_iter->make_next_page();
+                      if(l_page_next != nullptr) {
+                          m_page_last = l_page_next;
+                          m_page_idle++;
+                          m_page_count++;
+                      }
+                  }
+              }
+              l_page_iter = l_page_next;
+          }
+          return nullptr;
+  }
+
+  /* get_page_of()
+     find the page that owns the given (allocated) node: with aligned pages the owner is read from the start of the
+     page memory the node lives in, otherwise pages are searched backwards from the current one first
+  */
+          page_type* get_page_of(node_type* node) noexcept {
+          page_type* l_page_iter;
+          node_type* l_page_pos;
+          if(node) {
+              if(m_page_mask) {
+                  auto  l_page_base = reinterpret_cast<std::uintptr_t>(node) & m_page_mask;
+                  l_page_iter = *page_type::get_owner_ptr(reinterpret_cast<void*>(l_page_base));
+                  if(l_page_iter->find(node, l_page_pos)) {
+                      m_page_iter = l_page_iter;
+                      m_page_pos  = l_page_pos;
+                      return l_page_iter;
+                  }
+                  return nullptr;
+              }
+              l_page_iter = m_page_iter;
+              l_page_pos  = nullptr;
+              while(l_page_iter) {
+                  if(l_page_iter->find(node, l_page_pos)) {
+                      m_page_iter = l_page_iter;
+                      m_page_pos  = l_page_pos;
+                      return l_page_iter;
+                  }
+                  l_page_iter = l_page_iter->get_prev_page();
+              }
+              l_page_iter = m_page_iter->get_next_page();
+              while(l_page_iter) {
+                  if(l_page_iter->find(node, l_page_pos)) {
+                      m_page_iter = l_page_iter;
+                      m_page_pos  = l_page_pos;
+                      return l_page_iter;
+                  }
+                  l_page_iter = l_page_iter->get_next_page();
+              }
+          }
+          return nullptr;
+  }
+
+  /* free_notify()
+     called after a node has been freed from <page>; when automatic trimming is enabled and the page becomes empty,
+     allocation restarts from the root so that nodes gather in the first pages and the last ones can drain, and the
+     bank is trimmed once the number of idle pages reaches the configured threshold
+  */
+  inline  void free_notify(page_type* page) noexcept {
+          if(page->is_empty()) {
+              m_page_idle++;
+              if(m_page_trim) {
+                  m_page_iter = get_root_page();
+                  m_page_pos  = nullptr;
+                  if(m_page_idle >= m_page_spare + m_page_trim) {
+                      trim();
+                  }
+              }
+          }
+  }
 
   public:  
-  inline  bank() noexcept:
-          base_type(PageSize, std::numeric_limits<unsigned int>::max()),
+  /* bank()
+     align - allocate pages at power of two aligned addresses, so that remove() finds the page owning a node in
+             constant time; only nodes that were allocated from this bank may be passed to remove() in this mode
+  */
+  inline  bank(bool align = false) noexcept:
+          base_type(PageSize, std::numeric_limits<unsigned int>::max(), align),
           m_page_iter(this),
           m_page_pos(nullptr),
           m_page_count(1),
-          m_page_max(std::numeric_limits<unsigned int>::max()) {
+          m_page_max(std::numeric_limits<unsigned int>::max()),
+          m_page_mask(0),
+          m_page_last(this),
+          m_page_idle(1),
+          m_page_spare(0),
+          m_page_trim(0) {
+          if(align) {
+              m_page_mask = ~static_cast<std::uintptr_t>(base_type::get_align() - 1);
+          }
   }
 
           bank(const bank&) noexcept = delete;
@@ -65,61 +185,115 @@ class bank: public page<Xt, get_div_ub(PageSize, 8), ArraySize, Rt>
 
   template<typename... Args>
           node_type* emplace(Args&&... args) noexcept {
-          node_type* l_result = m_page_iter->find(nullptr, m_page_pos);
-          if(l_result) {
-              return m_page_iter->make_node(l_result, std::forward<Args>(args)...);
+          page_type* l_page;
+          node_type* l_node = get_free_node(l_page);
+          if(l_node) {
+              return l_page->make_node(l_node, std::forward<Args>(args)...);
           }
-          if(m_page_count < m_page_max) {
-              auto l_page_next = m_page_iter->get_next_page();
-              if(l_page_next == nullptr) {
-                  l_page_next = m_page_iter->make_next_page();
-                  if(l_page_next != nullptr) {
-                      m_page_iter = l_page_next;
-                      m_page_pos  = nullptr;
-                      m_page_count++;
-                      l_result = emplace(std::forward<Args>(args)...);
+          return nullptr;
+  }
+
+          node_type* remove(node_type* node) noexcept {
+          if(node) {
+              if(page_type* l_page = get_page_of(node); l_page) {
+                  l_page->free_node(node);
+                  free_notify(l_page);
+              } else
+                  return nullptr;
+          }
+          return node;
+  }
+
+  /* acquire()
+     reserve a node in the bank without constructing it
+  */
+          node_type* acquire() noexcept {
+          page_type* l_page;
+          node_type* l_node = get_free_node(l_page);
+          if(l_node) {
+              return l_page->map_set_node(l_node);
+          }
+          return nullptr;
+  }
+
+  /* release()
+     give back a node obtained via acquire(), without destroying it
+  */
+          node_type* release(node_type* node) noexcept {
+          if(node) {
+              if(page_type* l_page = get_page_of(node); l_page) {
+                  if(l_page->map_clear_node(node)) {
+                      free_notify(l_page);
+                      return node;
                   }
               }
           }
-          return l_result;
+          return nullptr;
   }
 
-          node_type* remove(node_type* node) noexcept {
-          page_type* l_page_iter;
-          node_type* l_page_pos;
-          if(node) {
-              l_page_iter = m_page_iter;
-              l_page_pos  = nullptr;
-              while(l_page_iter) {
-                  if(l_page_iter->find(node, l_page_pos)) {
-                      l_page_iter->free_node(node);
-                      m_page_iter = l_page_iter;
-                      m_page_pos  = l_page_pos;
+  /* trim()
+     release the empty pages at the end of the page list, then park the remaining empty pages and let the resource
+     reclaim their memory, so that no more than the configured number of spare pages stay idle;
+     returns the number of pages released or parked
+  */
+          unsigned int trim() noexcept {
+          unsigned int l_count = 0;
+          while((m_page_last != get_root_page()) &&
+              (m_page_last->is_empty())) {
+              if(m_page_last->m_map_cold == false) {
+                  if(m_page_idle <= m_page_spare) {
                       break;
                   }
-                  l_page_iter = l_page_iter->get_prev_page();
+                  m_page_idle--;
               }
-              if(l_page_iter == nullptr) {
-                  l_page_iter = m_page_iter->get_next_page();
-                  while(l_page_iter) {
-                      if(l_page_iter->find(node, l_page_pos)) {
-                          l_page_iter->free_node(node);
-                          m_page_iter = l_page_iter;
-                          m_page_pos  = l_page_pos;
-                          break;
-                      }
-                      l_page_iter = l_page_iter->get_next_page();
-                  }
-                  if(l_page_iter == nullptr) {
-                      return nullptr;
+              page_type* l_page_prev = m_page_last->get_prev_page();
+              if(m_page_iter == m_page_last) {
+                  m_page_iter = l_page_prev;
+                  m_page_pos  = nullptr;
+              }
+              l_page_prev->free_next_page();
+              m_page_last = l_page_prev;
+              m_page_count--;
+              l_count++;
+          }
+          // pages in the middle of the list can't be released, as each page object lives in the memory of the page
+          // before it; instead, park them and hand their node memory back to the system where the resource allows
+          page_type* l_page_iter = get_root_page();
+          while((l_page_iter != nullptr) &&
+              (m_page_idle > m_page_spare)) {
+              if(l_page_iter->is_empty()) {
+                  if(l_page_iter->m_map_cold == false) {
+                      l_page_iter->discard();
+                      l_page_iter->m_map_cold = true;
+                      m_page_idle--;
+                      l_count++;
                   }
               }
+              l_page_iter = l_page_iter->get_next_page();
           }
-          return node;
+          return l_count;
+  }
+
+  /* set_page_spare()
+     number of empty pages that trim() keeps ready for the next burst
+  */
+  inline  void set_page_spare(unsigned int count) noexcept {
+          m_page_spare = count;
   }
-  
-  inline  page_type* get_root_page() noexcept {
-          return this;
+
+  /* set_page_trim()
+     trim automatically once <count> empty pages above the spare count have gathered; 0 disables automatic trimming
+  */
+  inline  void set_page_trim(unsigned int count) noexcept {
+          m_page_trim = count;
+  }
+
+  inline  unsigned int get_page_count() const noexcept {
+          return m_page_count;
+  }
+
+  inline  page_type* get_root_page() const noexcept {
+          return const_cast<bank*>(this);
   }
 
   inline  page_type* get_current_page() const noexcept {
@@ -23,6 +23,8 @@
 **/
 #include "flat_set_traits.h"
 #include <compare.h>
+#include <algorithm>
+#include <vector>
 #include <memory_resource>
 
 namespace mmi {
@@ -50,7 +52,14 @@ class flat_set: public flat_set_traits<Xt>::base_type
   private:
   iterator_type m_pos;
   unsigned int  m_replace_bit:1; /*whether to replace an already existing element or fail*/
-  unsigned int  m_remove_bit:1;  /*whether to erase or invalidate an element upon removal (not implemented)*/
+  unsigned int  m_remove_bit:1;  /*whether to erase or invalidate an element upon removal*/
+  std::vector<bool>        m_dead_list;  /*invalidated nodes, kept empty while there are none*/
+  std::size_t              m_dead_count;
+  std::vector<key_type>    m_tree_keys;  /*frozen: keys in Eytzinger order, from 1*/
+  std::vector<std::size_t> m_tree_index; /*frozen: position in the sorted nodes of each key in m_tree_keys*/
+
+  static constexpr std::size_t dead_ratio = 4; /*compact once one node in <dead_ratio> is dead*/
+  static constexpr std::size_t tree_stride = sizeof(key_type) >= 32 ? 2 : (sizeof(key_type) >= 16 ? 4 : (sizeof(key_type) >= 8 ? 8 : 16));
 
   private:
   /* test_p()
@@ -95,7 +104,11 @@ class flat_set: public flat_set_traits<Xt>::base_type
   */
   template<typename... Args>
   inline  bool  place_p(Args&&... args) noexcept {
+          thaw();
           m_pos = base_type::emplace(m_pos, std::forward<Args>(args)...);
+          if(m_dead_list.size()) {
+              m_dead_list.insert(m_dead_list.begin() + (m_pos - base_type::begin()), false);
+          }
           return  true;
   }
 
@@ -103,7 +116,11 @@ class flat_set: public flat_set_traits<Xt>::base_type
    * blind insert before m_pos
   */
   inline  bool  place_p(const node_type& node) noexcept {
+          thaw();
           m_pos = base_type::insert(m_pos, node);
+          if(m_dead_list.size()) {
+              m_dead_list.insert(m_dead_list.begin() + (m_pos - base_type::begin()), false);
+          }
           return  true;
   }
 
@@ -121,6 +138,187 @@ class flat_set: public flat_set_traits<Xt>::base_type
           *m_pos = std::move(node);
   }
 
+  /* is_less()
+  */
+  static  bool  is_less(const node_type& lhs, const node_type& rhs) noexcept {
+          return  lhs < rhs;
+  }
+
+  /* unique_p()
+   * drop repeated keys from the sorted range [first, end()), keeping the last of each run if replacing, the first
+   * one otherwise
+  */
+          void  unique_p(iterator_type first) noexcept {
+          iterator_type l_last = base_type::end();
+          if(first != l_last) {
+              iterator_type l_node = first;
+              for(iterator_type i_node = std::next(first); i_node != l_last; ++i_node) {
+                  if(*l_node < *i_node) {
+                      ++l_node;
+                      if(l_node != i_node) {
+                          *l_node = std::move(*i_node);
+                      }
+                  } else
+                  if(m_replace_bit) {
+                      *l_node = std::move(*i_node);
+                  }
+              }
+              base_type::erase(std::next(l_node), l_last);
+          }
+  }
+
+  /* merge_p()
+   * merge the nodes appended from <size> on into the sorted nodes before them, in place
+  */
+          std::size_t merge_p(std::size_t size, bool sort) noexcept {
+          thaw();
+          if(base_type::size() > size) {
+              if(sort) {
+                  std::stable_sort(base_type::begin() + size, base_type::end(), is_less);
+                  unique_p(base_type::begin() + size);
+              }
+              if(size) {
+                  iterator_type l_middle = base_type::begin() + size;
+                  if(is_less(*std::prev(l_middle), *l_middle) == false) {
+                      std::inplace_merge(base_type::begin(), l_middle, base_type::end(), is_less);
+                      unique_p(base_type::begin());
+                  }
+              }
+          }
+          m_pos = base_type::end();
+          return  base_type::size() - size;
+  }
+
+  /* is_dead_p()
+   * check if the node at <pos> has been invalidated
+  */
+  inline  bool  is_dead_p(iterator_type pos) noexcept {
+          if(m_dead_count) {
+              return m_dead_list[pos - base_type::begin()];
+          }
+          return  false;
+  }
+
+  /* kill_p()
+   * invalidate the node at <pos>, leaving it in place as a tombstone
+  */
+  inline  void  kill_p(iterator_type pos) noexcept {
+          std::size_t l_index = pos - base_type::begin();
+          if(m_dead_list.empty()) {
+              m_dead_list.resize(base_type::size(), false);
+          }
+          if(m_dead_list[l_index] == false) {
+              m_dead_list[l_index] = true;
+              ++m_dead_count;
+          }
+  }
+
+  /* revive_p()
+   * take the tombstone at m_pos back into use, if there is one there
+  */
+  inline  bool  revive_p() noexcept {
+          if(is_dead_p(m_pos)) {
+              m_dead_list[m_pos - base_type::begin()] = false;
+              if(--m_dead_count == 0) {
+                  m_dead_list.clear();
+              }
+              return true;
+          }
+          return  false;
+  }
+
+  /* unlink_p()
+   * drop the flag of the node at <index>, which is about to be erased; the list is released along with the last
+   * tombstone, so that it is either empty or as long as the node vector
+  */
+  inline  void  unlink_p(std::size_t index) noexcept {
+          if(m_dead_list.size()) {
+              m_dead_count -= m_dead_list[index];
+              if(m_dead_count) {
+                  m_dead_list.erase(m_dead_list.begin() + index);
+              } else
+                  m_dead_list.clear();
+          }
+  }
+
+  /* compact_p()
+   * drop the tombstones, moving the live nodes down in a single pass; returns the new position of the first live
+   * node at or after <index>
+  */
+          std::size_t compact_p(std::size_t index) noexcept {
+          std::size_t l_size = base_type::size();
+          std::size_t l_next = 0;
+          std::size_t l_result = l_size;
+          thaw();
+          for(std::size_t i_node = 0; i_node < l_size; i_node++) {
+              if(i_node == index) {
+                  l_result = l_next;
+              }
+              if(m_dead_list[i_node] == false) {
+                  if(l_next != i_node) {
+                      base_type::operator[](l_next) = std::move(base_type::operator[](i_node));
+                  }
+                  ++l_next;
+              }
+          }
+          if(l_result > l_next) {
+              l_result = l_next;
+          }
+          base_type::erase(base_type::begin() + l_next, base_type::end());
+          m_dead_list.clear();
+          m_dead_count = 0;
+          m_pos = base_type::end();
+          return  l_result;
+  }
+
+  /* collect_p()
+   * compact if enough of the nodes are dead; returns the new position of the node at <index>
+  */
+  inline  std::size_t collect_p(std::size_t index) noexcept {
+          if(m_dead_count * dead_ratio >= base_type::size()) {
+              bool l_frozen = is_frozen();
+              index = compact_p(index);
+              if(l_frozen) {
+                  freeze();
+              }
+          }
+          return  index;
+  }
+
+  /* freeze_p()
+   * lay the keys out in Eytzinger order: node <k> of the implicit tree has its children at 2k and 2k + 1, filled in
+   * order from the sorted nodes
+  */
+          void  freeze_p(std::size_t index, std::size_t& next) noexcept {
+          if(index < m_tree_keys.size()) {
+              freeze_p(index * 2, next);
+              m_tree_keys[index]  = base_type::operator[](next);
+              m_tree_index[index] = next++;
+              freeze_p(index * 2 + 1, next);
+          }
+  }
+
+  /* find_e()
+   * branchless descent of the Eytzinger tree, fetching the cache line a few levels ahead; leaves m_pos at the first
+   * node not less than <key>
+  */
+          bool  find_e(key_type key) noexcept {
+          const key_type* l_tree = m_tree_keys.data();
+          std::size_t     l_size = m_tree_keys.size();
+          std::size_t     l_index = 1;
+          while(l_index < l_size) {
+              __builtin_prefetch(l_tree + l_index * tree_stride);
+              l_index = l_index * 2 + (l_tree[l_index] < key);
+          }
+          l_index >>= __builtin_ffsll(static_cast<long long>(~l_index));
+          if(l_index) {
+              m_pos = base_type::begin() + m_tree_index[l_index];
+              return (key < l_tree[l_index]) == false;
+          }
+          m_pos = base_type::end();
+          return false;
+  }
+
   /* reset_p()
    * try to set the pointer into a valid state if it's at the end()
   */
@@ -135,30 +333,47 @@ class flat_set: public flat_set_traits<Xt>::base_type
           base_type(),
           m_pos(base_type::end()),
           m_replace_bit(replace),
-          m_remove_bit(remove) {
+          m_remove_bit(remove),
+          m_dead_list(),
+          m_dead_count(0),
+          m_tree_keys(),
+          m_tree_index() {
   }
 
   inline  flat_set(size_t reserve, bool replace = false, bool remove = true) noexcept:
           base_type(),
           m_pos(),
           m_replace_bit(replace),
-          m_remove_bit(remove) {
+          m_remove_bit(remove),
+          m_dead_list(),
+          m_dead_count(0),
+          m_tree_keys(),
+          m_tree_index() {
           base_type::reserve(reserve);
           m_pos = base_type::end();
   }
 
   inline  flat_set(const flat_set& copy) noexcept:
           base_type(copy),
-          m_pos(copy.m_pos),
+          m_pos(),
           m_replace_bit(copy.m_replace_bit),
-          m_remove_bit(copy.m_remove_bit) {
+          m_remove_bit(copy.m_remove_bit),
+          m_dead_list(copy.m_dead_list),
+          m_dead_count(copy.m_dead_count),
+          m_tree_keys(copy.m_tree_keys),
+          m_tree_index(copy.m_tree_index) {
+          m_pos = base_type::end();
   }
 
   inline  flat_set(flat_set&& copy) noexcept:
           base_type(std::move(copy)),
           m_pos(std::move(copy.m_pos)),
           m_replace_bit(copy.m_replace_bit),
-          m_remove_bit(copy.m_remove_bit) {
+          m_remove_bit(copy.m_remove_bit),
+          m_dead_list(std::move(copy.m_dead_list)),
+          m_dead_count(copy.m_dead_count),
+          m_tree_keys(std::move(copy.m_tree_keys)),
+          m_tree_index(std::move(copy.m_tree_index)) {
   }
 
           ~flat_set() {
@@ -167,11 +382,21 @@ class flat_set: public flat_set_traits<Xt>::base_type
   /* find()
   */
   inline  iterator_type find(key_type key) noexcept {
+          if(m_tree_keys.size()) {
+              if(find_e(key)) {
+                  if(is_dead_p(m_pos) == false) {
+                      return m_pos;
+                  }
+              }
+              return base_type::end();
+          }
           reset_p();
           if(find_p(key)) {
-              return m_pos;
-          } else
-              return base_type::end();
+              if(is_dead_p(m_pos) == false) {
+                  return m_pos;
+              }
+          }
+          return  base_type::end();
   }
 
   inline  bool contains(key_type key) noexcept {
@@ -183,6 +408,10 @@ class flat_set: public flat_set_traits<Xt>::base_type
           iterator_type insert(key_type key) noexcept {
           reset_p();
           if(find_p(key)) {
+              if(revive_p()) {
+                  *m_pos = key;
+                  return m_pos;
+              }
           } else
           if(place_p(key)) {
               return m_pos;
@@ -196,6 +425,10 @@ class flat_set: public flat_set_traits<Xt>::base_type
           iterator_type insert(key_type key, Args&&... args) noexcept {
           reset_p();
           if(find_p(key)) {
+              if(revive_p()) {
+                  *m_pos = value_type(std::forward<Args>(args)...);
+                  return m_pos;
+              }
               if(m_replace_bit) {
                   *m_pos = value_type(std::forward<Args>(args)...);
               }
@@ -211,7 +444,7 @@ class flat_set: public flat_set_traits<Xt>::base_type
           iterator_type insert(key_type key, const value_type& value) noexcept {
           reset_p();
           if(find_p(key)) {
-              if(m_replace_bit) {
+              if(revive_p() || m_replace_bit) {
                   *m_pos = value;
                   return m_pos;
               }
@@ -227,7 +460,7 @@ class flat_set: public flat_set_traits<Xt>::base_type
           iterator_type insert(key_type key, value_type&& value) noexcept {
           reset_p();
           if(find_p(key)) {
-              if(m_replace_bit) {
+              if(revive_p() || m_replace_bit) {
                   *m_pos = std::move(value);
                   return m_pos;
               }
@@ -245,21 +478,112 @@ class flat_set: public flat_set_traits<Xt>::base_type
           reset_p();
           if(find_p(key)) {
               if(m_remove_bit) {
+                  thaw();
+                  unlink_p(m_pos - base_type::begin());
                   m_pos = base_type::erase(m_pos);
+              } else {
+                  kill_p(m_pos);
+                  m_pos = base_type::begin() + collect_p(m_pos - base_type::begin());
               }
           }
   }
 
   inline  auto remove(iterator_type pos) noexcept -> iterator_type {
-          m_pos = base_type::erase(pos);
+          std::size_t l_index = pos - base_type::cbegin();
+          if(m_remove_bit) {
+              thaw();
+              unlink_p(l_index);
+              m_pos = base_type::erase(pos);
+          } else {
+              kill_p(base_type::begin() + l_index);
+              m_pos = base_type::begin() + collect_p(l_index + 1);
+          }
           return m_pos;
   }
 
   inline  auto remove(const_iterator_type pos) noexcept -> iterator_type {
-          m_pos = base_type::erase(pos);
+          std::size_t l_index = pos - base_type::cbegin();
+          if(m_remove_bit) {
+              thaw();
+              unlink_p(l_index);
+              m_pos = base_type::erase(pos);
+          } else {
+              kill_p(base_type::begin() + l_index);
+              m_pos = base_type::begin() + collect_p(l_index + 1);
+          }
           return m_pos;
   }
 
+  /* assign_sorted()
+   * replace the contents with the keys in [first, last), expected in key order; repeated keys are dropped as by
+   * insert(); an unsorted range is sorted first
+  */
+  template<typename It>
+  inline  std::size_t assign_sorted(It first, It last) noexcept {
+          thaw();
+          base_type::clear();
+          m_dead_list.clear();
+          m_dead_count = 0;
+          for(; first != last; ++first) {
+              base_type::emplace_back(*first);
+          }
+          if(std::is_sorted(base_type::begin(), base_type::end(), is_less) == false) {
+              std::stable_sort(base_type::begin(), base_type::end(), is_less);
+          }
+          unique_p(base_type::begin());
+          m_pos = base_type::end();
+          return  base_type::size();
+  }
+
+  /* insert_bulk()
+   * insert the keys in [first, last), in any order: they are appended, sorted once and merged with the
+   * existing ones, instead of being placed one at a time; repeated keys are handled as by insert(); returns the
+   * number of keys added
+  */
+  template<typename It>
+  inline  std::size_t insert_bulk(It first, It last) noexcept {
+          if(m_dead_count) {
+              compact_p(0);
+          }
+          std::size_t l_size = base_type::size();
+          for(; first != last; ++first) {
+              base_type::emplace_back(*first);
+          }
+          return  merge_p(l_size, true);
+  }
+
+  /* merge()
+   * insert all the nodes of <other>, as insert_bulk() does; returns the number of keys added
+  */
+  inline  std::size_t merge(const flat_set& other) noexcept {
+          if(m_dead_count) {
+              compact_p(0);
+          }
+          std::size_t l_size = base_type::size();
+          if(other.m_dead_count) {
+              for(std::size_t i_node = 0; i_node < other.base_type::size(); i_node++) {
+                  if(other.m_dead_list[i_node] == false) {
+                      base_type::push_back(other.base_type::operator[](i_node));
+                  }
+              }
+          } else
+              base_type::insert(base_type::end(), other.cbegin(), other.cend());
+          return  merge_p(l_size, false);
+  }
+
+  inline  std::size_t merge(flat_set&& other) noexcept {
+          if(m_dead_count) {
+              compact_p(0);
+          }
+          if(other.m_dead_count) {
+              other.compact_p(0);
+          }
+          std::size_t l_size = base_type::size();
+          base_type::insert(base_type::end(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+          other.clear(0);
+          return  merge_p(l_size, false);
+  }
+
   inline  iterator_type begin() noexcept {
           return base_type::begin();
   }
@@ -284,6 +608,67 @@ class flat_set: public flat_set_traits<Xt>::base_type
           return base_type::end();
   }
 
+  /* freeze()
+   * build a read-optimised copy of the keys, laid out in Eytzinger order, which find() searches from then on instead
+   * of binary searching the nodes; the nodes themselves stay sorted and iterable. Any change made through this
+   * interface drops the copy again; changes made directly to the underlying vector must be followed by thaw().
+  */
+  inline  void freeze() noexcept {
+          std::size_t l_next = 0;
+          if(m_dead_count) {
+              compact_p(0);
+          }
+          m_tree_keys.resize(base_type::size() + 1);
+          m_tree_index.resize(base_type::size() + 1);
+          freeze_p(1, l_next);
+          if(base_type::empty()) {
+              thaw();
+          }
+  }
+
+  /* thaw()
+   * drop the read-optimised copy of the keys and go back to binary searching the nodes
+  */
+  inline  void thaw() noexcept {
+          if(m_tree_keys.size()) {
+              m_tree_keys.clear();
+              m_tree_keys.shrink_to_fit();
+              m_tree_index.clear();
+              m_tree_index.shrink_to_fit();
+          }
+  }
+
+  inline  bool is_frozen() const noexcept {
+          return m_tree_keys.empty() == false;
+  }
+
+  /* compact()
+   * drop the nodes invalidated by remove(); returns how many were dropped
+  */
+  inline  std::size_t compact() noexcept {
+          std::size_t l_result = m_dead_count;
+          if(m_dead_count) {
+              bool l_frozen = is_frozen();
+              compact_p(0);
+              if(l_frozen) {
+                  freeze();
+              }
+          }
+          return  l_result;
+  }
+
+  /* is_removed()
+   * check if the node at <pos> is a tombstone, left behind by remove() on a container made not to erase; iterating
+   * over the container visits them until it is compacted
+  */
+  inline  bool is_removed(iterator_type pos) noexcept {
+          return  is_dead_p(pos);
+  }
+
+  inline  std::size_t get_removed_count() const noexcept {
+          return  m_dead_count;
+  }
+
   /* reserve()
   */
   inline  void reserve(size_t count) noexcept {
@@ -293,20 +678,37 @@ class flat_set: public flat_set_traits<Xt>::base_type
   /* clear()
   */
   inline  void clear(size_t /*count*/) noexcept {
+          thaw();
           base_type::clear();
+          m_dead_list.clear();
+          m_dead_count = 0;
+          m_pos = base_type::end();
   }
 
+  /* size()
+   * number of live nodes
+  */
   inline  std::size_t size() const noexcept {
-          return base_type::size();
+          return base_type::size() - m_dead_count;
   }
 
   inline  flat_set& operator=(const flat_set& rhs) noexcept {
           base_type::operator=(rhs);
+          m_pos = base_type::end();
+          m_dead_list = rhs.m_dead_list;
+          m_dead_count = rhs.m_dead_count;
+          m_tree_keys = rhs.m_tree_keys;
+          m_tree_index = rhs.m_tree_index;
           return *this;
   }
 
   inline  flat_set& operator=(flat_set&& rhs) noexcept {
           base_type::operator=(std::move(rhs));
+          m_pos = base_type::end();
+          m_dead_list = std::move(rhs.m_dead_list);
+          m_dead_count = rhs.m_dead_count;
+          m_tree_keys = std::move(rhs.m_tree_keys);
+          m_tree_index = std::move(rhs.m_tree_index);
           return *this;
   }
 };
@@ -21,21 +21,29 @@
     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **/
-#include "flat_map_traits.h"
+#include "hash_table.h"
 #include <hash.h>
-#include <compare.h>
 
 namespace mmi {
-  
+
+/* hash_map
+   map of precomputed hashes to values, over an open addressing hash_table; keys are hashed with fnv and only their
+   hashes are kept, so two keys with the same hash are taken for the same key
+   Kt - key type
+   Xt - value type
+   Ht - hash type (default: std::uint64_t)
+*/
 template<typename Kt, typename Xt, typename Ht = std::uint64_t>
-class hash_map: protected flat_map_traits<Ht, Xt>::base_type
+class hash_map: protected hash_table<Ht, Xt>
 {
   public:
   using  key_type   = typename flat_map_traits<Kt, Xt>::key_type;
   using  value_type = typename flat_map_traits<Kt, Xt>::value_type;
   using  hash_type  = typename flat_map_traits<Ht, Xt>::key_type;
   using  node_type  = typename flat_map_traits<Ht, Xt>::node_type;
-  using  base_type  = typename flat_map_traits<Ht, Xt>::base_type;
+  using  base_type  = hash_table<Ht, Xt>;
+
+  static_assert(std::is_same<key_type, hash_type>::value == false, "key and hash types should differ");
 
   public:
   using  node_forward_type = typename std::conditional<
@@ -44,90 +52,16 @@ class hash_map: protected flat_map_traits<Ht, Xt>::base_type
           node_type
          >::type;
 
-  using  iterator_type = typename flat_map_traits<Ht, Xt>::iterator_type;
+  using  iterator_type = typename base_type::iterator_type;
   using  result_type   = node_type*;
 
   private:
-  iterator_type m_pos;
   unsigned int  m_replace_bit:1; /*whether to replace an already existing element or fail*/
-  unsigned int  m_remove_bit:1;  /*whether to erase or invalidate an element upon removal*/
+  unsigned int  m_remove_bit:1;  /*whether to reclaim the tombstones left by removal as they pile up, or only on compact()*/
 
   private:
-  /* test_p()
-  */
-  inline  bool test_p(hash_type key) noexcept {
-          int  cmp = compare(m_pos->key, key);
-          if(cmp == 0) {
-              return true;
-          } else
-          if(cmp < 0) {
-            ++m_pos;
-          }
-          return false;
-  }
-
-  /* find_p()
-   * binary search with m_pos as initial pivot
-  */
-          bool find_p(hash_type key) noexcept {
-          int  cmp;
-          if(m_pos != base_type::end()) {
-              cmp = compare(m_pos->key, key);
-              if(cmp < 0) {
-                  m_pos = std::lower_bound(m_pos + 1, base_type::end(), key);
-                  if(m_pos != base_type::end()) {
-                      return test_p(key);
-                  }
-              } else
-              if(cmp > 0) {
-                  m_pos = std::lower_bound(base_type::begin(), m_pos - 1, key);
-                  if(m_pos != base_type::end()) {
-                      return test_p(key);
-                  }
-              } else
-                  return true;
-          }
-          return false;
-  }
-
-  /* place_p()
-   * blind insert before m_pos
-  */
-  template<typename... Args>
-  inline  bool  place_p(Args&&... args) noexcept {
-          m_pos = base_type::emplace(m_pos, std::forward<Args>(args)...);
-          return  true;
-  }
-
-  /* place_p()
-   * blind insert before m_pos
-  */
-  inline  bool  place_p(const node_type& node) noexcept {
-          m_pos = base_type::insert(m_pos, node);
-          return  true;
-  }
-
-  /* replace_p()
-   * replace node at m_pos
-  */
-  inline  void  replace_p(const node_type& node) noexcept {
-          *m_pos = node;
-  }
-
-  /* replace_p()
-   * replace node at m_pos
-  */
-  inline  void  replace_p(node_type&& node) noexcept {
-          *m_pos = std::move(node);
-  }
-
-  /* reset_p()
-   * try to set the pointer into a valid state if it's at the end()
-  */
-  inline  void  reset_p() noexcept {
-          if(m_pos == base_type::end()) {
-              m_pos = base_type::begin() + (base_type::size() / 2);
-          }
+  static  hash_type get_hash(key_type key) noexcept {
+          return fnv<Ht>(key).get_value();
   }
 
   public:
@@ -137,10 +71,8 @@ class hash_map: protected flat_map_traits<Ht, Xt>::base_type
               bool remove = true
           ) noexcept:
           base_type(r),
-          m_pos(),
           m_replace_bit(replace),
           m_remove_bit(remove) {
-          m_pos = base_type::end();
   }
 
   inline  hash_map(
@@ -150,23 +82,19 @@ class hash_map: protected flat_map_traits<Ht, Xt>::base_type
               bool remove = true
           ) noexcept:
           base_type(r),
-          m_pos(),
           m_replace_bit(replace),
           m_remove_bit(remove) {
           base_type::reserve(reserve);
-          m_pos = base_type::end();
   }
 
   inline  hash_map(const hash_map& copy) noexcept:
           base_type(copy),
-          m_pos(copy.m_pos),
           m_replace_bit(copy.m_replace_bit), 
           m_remove_bit(copy.m_remove_bit) {
   }
 
   inline  hash_map(hash_map&& copy) noexcept:
           base_type(std::move(copy)),
-          m_pos(std::move(copy.m_pos)),
           m_replace_bit(copy.m_replace_bit), 
           m_remove_bit(copy.m_remove_bit) {
   }
@@ -177,131 +105,98 @@ class hash_map: protected flat_map_traits<Ht, Xt>::base_type
   /* find()
   */
   inline  iterator_type find(key_type key) noexcept {
-          hash_ptr hash(key);
-          return   find(hash);
+          return   find(get_hash(key));
   }
 
-  /* find_hash()
+  /* find()
   */
   inline  iterator_type find(hash_type hash) noexcept {
-          reset_p();
-          if(find_p(hash)) {
-              return m_pos;
-          } else
-              return base_type::end();
+          return   base_type::get_iterator(base_type::find(hash));
   }
 
   /* insert()
   */
   inline  iterator_type insert(key_type key) noexcept {
-          hash_ptr hash(key);
-          return   insert(hash);
+          return   insert(get_hash(key));
   }
 
   /* insert()
+   * fails if the hash is already there
   */
   inline  iterator_type insert(hash_type hash) noexcept {
-          reset_p();
-          if(find_p(hash)) {
-          } else
-          if(place_p(hash)) {
-              return m_pos;
+          auto     l_result = base_type::emplace(hash);
+          if(l_result.second) {
+              return base_type::get_iterator(l_result.first);
           }
-          return base_type::end();
+          return   base_type::end();
   }
 
   /* insert()
   */
   template<typename... Args>
   inline  iterator_type insert(key_type key, Args&&... args) noexcept {
-          hash_ptr hash(key);
-          return   insert(hash, std::forward<Args>(args)...);
+          return   insert_hash(get_hash(key), std::forward<Args>(args)...);
   }
 
   /* insert()
   */
   template<typename... Args>
-  inline  iterator_type insert_hash(hash_type hash, Args&&... args) noexcept {
-          reset_p();
-          if(find_p(hash)) {
-              if(m_replace_bit) {
-                  m_pos->value = value_type(std::forward<Args>(args)...);
-              }
-          } else
-          if(place_p(hash, std::forward<Args>(args)...)) {
-              return m_pos;
-          }
-          return base_type::end();
-  }
-
-  /* insert()
-  */
-  inline  iterator_type insert(key_type key, const value_type& value) noexcept {
-          hash_ptr hash(key);
-          return   insert(hash, value);
-  }
-
-  /* insert()
-  */
-  inline  iterator_type insert(hash_type hash, const value_type& value) noexcept {
-          reset_p();
-          if(find_p(hash)) {
-              if(m_replace_bit) {
-                  m_pos->value = value;
-                  return m_pos;
-              }
-          } else
-          if(place_p(hash, value)) {
-              return m_pos;
-          }
-          return base_type::end();
-  }
-
-  /* insert()
-  */
-  inline  iterator_type insert(key_type key, value_type&& value) noexcept {
-          hash_ptr hash(key);
-          return   insert(hash, std::move(value));
+  inline  iterator_type insert(hash_type hash, Args&&... args) noexcept {
+          return   insert_hash(hash, std::forward<Args>(args)...);
   }
 
-  /* insert()
+  /* insert_hash()
+   * construct the value for <hash> from <args>; if the hash is already there, replace its value if the map was made
+   * to, fail otherwise
   */
-  inline  iterator_type insert(hash_type hash, value_type&& value) noexcept {
-          reset_p();
-          if(find_p(hash)) {
+  template<typename... Args>
+  inline  iterator_type insert_hash(hash_type hash, Args&&... args) noexcept {
+          if(node_type* l_node = base_type::find(hash); l_node != nullptr) {
               if(m_replace_bit) {
-                  m_pos->value = std::move(value);
-                  return m_pos;
+                  l_node->value = value_type(std::forward<Args>(args)...);
+                  return base_type::get_iterator(l_node);
               }
-          } else
-          if(place_p(hash, std::move(value))) {
-              return m_pos;
+              return base_type::end();
           }
-          return base_type::end();
+          return   base_type::get_iterator(base_type::emplace(hash, std::forward<Args>(args)...).first);
   }
 
   /* remove()
    * erase node of given key, if found
   */
-  inline  iterator_type remove(key_type key) noexcept {
-          hash_ptr hash(key);
-          return   remove(hash);
+  inline  void remove(key_type key) noexcept {
+          remove(get_hash(key));
   }
 
   /* remove()
    * erase node of given hash, if found
   */
   inline  void remove(hash_type hash) noexcept {
-          reset_p();
-          if(find_p(hash)) {
-              m_pos = base_type::erase(m_pos);
+          if(base_type::erase(hash)) {
+              if(m_remove_bit) {
+                  base_type::collect();
+              }
           }
   }
 
   /* remove()
   */
   inline  void remove(iterator_type pos) noexcept {
-          m_pos = base_type::erase(pos);
+          base_type::erase(pos.get());
+          if(m_remove_bit) {
+              base_type::collect();
+          }
+  }
+
+  /* compact()
+   * drop the tombstones and shrink the table to fit
+  */
+  inline  void compact() noexcept {
+          base_type::compact();
+  }
+
+  inline  size_t get_removed_count() const noexcept {
+          return base_type::get_removed_count();
   }
 
   inline  iterator_type begin() noexcept {
@@ -315,6 +210,10 @@ class hash_map: protected flat_map_traits<Ht, Xt>::base_type
   inline  iterator_type end() noexcept {
           return base_type::end();
   }
+
+  inline  size_t size() const noexcept {
+          return base_type::size();
+  }
   
   /* reserve()
   */
@@ -324,17 +223,21 @@ class hash_map: protected flat_map_traits<Ht, Xt>::base_type
 
   /* clear()
   */
-  inline  void clear(size_t) noexcept {
+  inline  void clear(size_t = 0) noexcept {
           base_type::clear();
   }
 
   inline  hash_map& operator=(const hash_map& rhs) noexcept {
           base_type::operator=(rhs);
+          m_replace_bit = rhs.m_replace_bit;
+          m_remove_bit = rhs.m_remove_bit;
           return *this;
   }
 
   inline  hash_map& operator=(hash_map&& rhs) noexcept {
           base_type::operator=(std::move(rhs));
+          m_replace_bit = rhs.m_replace_bit;
+          m_remove_bit = rhs.m_remove_bit;
           return *this;
   }
 };
@@ -0,0 +1,626 @@
+#ifndef mmi_hash_table_h
+#define mmi_hash_table_h
+/** 
+    Copyright (c) 2024, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include "flat_map_traits.h"
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mmi {
+
+/* hash_table
+   open addressing hash table, keyed on precomputed hashes;
+   slots are paired with control bytes telling whether a slot is empty, deleted or full and, for a full slot, 7 more
+   bits of its hash; lookups scan the control bytes a group at a time and only look at slots whose control bytes
+   match, so most misses never touch the slots at all. Removed slots become tombstones unless no probe can have run
+   past them; the table is rebuilt when it runs out of room, in place if enough of it is tombstones.
+   Ht - hash type
+   Xt - value type
+*/
+template<typename Ht, typename Xt>
+class hash_table
+{
+  public:
+  using  hash_type  = typename flat_map_traits<Ht, Xt>::key_type;
+  using  value_type = typename flat_map_traits<Ht, Xt>::value_type;
+  using  node_type  = typename flat_map_traits<Ht, Xt>::node_type;
+  using  ctrl_type  = std::int8_t;
+
+  static constexpr ctrl_type   ctrl_empty   = -128;
+  static constexpr ctrl_type   ctrl_deleted = -2;
+  static constexpr std::size_t group_size = 16;
+  static constexpr std::size_t capacity_min = group_size;
+  static constexpr std::size_t dead_ratio = 4;
+
+  private:
+  /* group
+     control bytes of <group_size> consecutive slots, matched all at once
+  */
+  class group
+  {
+#if defined(__SSE2__)
+    __m128i   m_ctrl;
+
+    public:
+    inline  group(const ctrl_type* ctrl) noexcept:
+            m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {
+    }
+
+    inline  unsigned int match(ctrl_type value) const noexcept {
+            return static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), m_ctrl)));
+    }
+
+    // empty and deleted are the only negative values short of -1
+    inline  unsigned int match_free() const noexcept {
+            return static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), m_ctrl)));
+    }
+#else
+    ctrl_type m_ctrl[group_size];
+
+    public:
+    inline  group(const ctrl_type* ctrl) noexcept {
+            std::memcpy(m_ctrl, ctrl, group_size);
+    }
+
+    inline  unsigned int match(ctrl_type value) const noexcept {
+            unsigned int l_mask = 0;
+            for(std::size_t i_ctrl = 0; i_ctrl < group_size; i_ctrl++) {
+                l_mask |= static_cast<unsigned int>(m_ctrl[i_ctrl] == value) << i_ctrl;
+            }
+            return l_mask;
+    }
+
+    inline  unsigned int match_free() const noexcept {
+            unsigned int l_mask = 0;
+            for(std::size_t i_ctrl = 0; i_ctrl < group_size; i_ctrl++) {
+                l_mask |= static_cast<unsigned int>(m_ctrl[i_ctrl] < -1) << i_ctrl;
+            }
+            return l_mask;
+    }
+#endif
+
+    inline  unsigned int match_empty() const noexcept {
+            return match(ctrl_empty);
+    }
+  };
+
+  public:
+  /* iterator_type
+     walks the full slots
+  */
+  class iterator_type
+  {
+    const ctrl_type* m_ctrl;
+    const ctrl_type* m_ctrl_end;
+    node_type*       m_node;
+
+    private:
+    inline  void skip() noexcept {
+            while((m_ctrl != m_ctrl_end) && (*m_ctrl < 0)) {
+                ++m_ctrl;
+                ++m_node;
+            }
+    }
+
+    public:
+    inline  iterator_type() noexcept:
+            m_ctrl(nullptr),
+            m_ctrl_end(nullptr),
+            m_node(nullptr) {
+    }
+
+    inline  iterator_type(const ctrl_type* ctrl, const ctrl_type* ctrl_end, node_type* node) noexcept:
+            m_ctrl(ctrl),
+            m_ctrl_end(ctrl_end),
+            m_node(node) {
+            skip();
+    }
+
+    inline  node_type* get() const noexcept {
+            return m_node;
+    }
+
+    inline  node_type& operator*() const noexcept {
+            return *m_node;
+    }
+
+    inline  node_type* operator->() const noexcept {
+            return m_node;
+    }
+
+    inline  iterator_type& operator++() noexcept {
+            ++m_ctrl;
+            ++m_node;
+            skip();
+            return *this;
+    }
+
+    inline  iterator_type operator++(int) noexcept {
+            iterator_type l_result(*this);
+            ++(*this);
+            return l_result;
+    }
+
+    inline  bool operator==(const iterator_type& rhs) const noexcept {
+            return m_ctrl == rhs.m_ctrl;
+    }
+
+    inline  bool operator!=(const iterator_type& rhs) const noexcept {
+            return m_ctrl != rhs.m_ctrl;
+    }
+  };
+
+  private:
+  std::pmr::memory_resource* m_resource;
+  node_type*    m_node_list;
+  ctrl_type*    m_ctrl_list;      // <capacity> control bytes, followed by a copy of the first <group_size - 1>
+  std::size_t   m_capacity;       // zero or a power of two
+  std::size_t   m_size;
+  std::size_t   m_growth;         // how many more empty slots can be filled before the table has to be rebuilt
+  std::size_t   m_dead;           // tombstones
+
+  private:
+  /* get_mix()
+     spread the bits of the hash, so that poorly distributed hashes don't end up in the same groups
+  */
+  static  std::uint64_t get_mix(hash_type hash) noexcept {
+          std::uint64_t l_mix = static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ull;
+          return l_mix ^ (l_mix >> 32);
+  }
+
+  static  ctrl_type get_h2(std::uint64_t mix) noexcept {
+          return static_cast<ctrl_type>(mix & 0x7f);
+  }
+
+  static  std::size_t get_growth_max(std::size_t capacity) noexcept {
+          return capacity - capacity / 8;
+  }
+
+  static  unsigned int get_first(unsigned int mask) noexcept {
+          return static_cast<unsigned int>(__builtin_ctz(mask));
+  }
+
+  inline  void  set_ctrl(std::size_t index, ctrl_type value) noexcept {
+          m_ctrl_list[index] = value;
+          if(index < group_size - 1) {
+              m_ctrl_list[m_capacity + index] = value;
+          }
+  }
+
+  /* find_p()
+     index of the slot holding <hash> for which <match> holds, or <m_capacity> if there is none
+  */
+  template<typename Mt>
+  inline  std::size_t find_p(hash_type hash, Mt&& match) const noexcept {
+          if(m_size) {
+              std::uint64_t l_mix  = get_mix(hash);
+              ctrl_type     l_h2   = get_h2(l_mix);
+              std::size_t   l_mask = m_capacity - 1;
+              std::size_t   l_pos  = (l_mix >> 7) & l_mask;
+              std::size_t   l_step = 0;
+              while(true) {
+                  group        l_group(m_ctrl_list + l_pos);
+                  unsigned int l_match = l_group.match(l_h2);
+                  while(l_match) {
+                      std::size_t l_index = (l_pos + get_first(l_match)) & l_mask;
+                      if((m_node_list[l_index].key == hash) &&
+                          match(m_node_list[l_index])) {
+                          return l_index;
+                      }
+                      l_match &= l_match - 1;
+                  }
+                  if(l_group.match_empty()) {
+                      break;
+                  }
+                  l_step += group_size;
+                  if(l_step > m_capacity) {
+                      break;
+                  }
+                  l_pos = (l_pos + l_step) & l_mask;
+              }
+          }
+          return m_capacity;
+  }
+
+  inline  std::size_t find_p(hash_type hash) const noexcept {
+          return find_p(hash, [](const node_type&) noexcept { return true; });
+  }
+
+  /* find_free_p()
+     index of the first empty or deleted slot on the probe sequence of <mix>
+  */
+  inline  std::size_t find_free_p(std::uint64_t mix) const noexcept {
+          std::size_t   l_mask = m_capacity - 1;
+          std::size_t   l_pos  = (mix >> 7) & l_mask;
+          std::size_t   l_step = 0;
+          while(true) {
+              unsigned int l_match = group(m_ctrl_list + l_pos).match_free();
+              if(l_match) {
+                  return (l_pos + get_first(l_match)) & l_mask;
+              }
+              l_step += group_size;
+              l_pos = (l_pos + l_step) & l_mask;
+          }
+  }
+
+  /* rehash_p()
+     rebuild the table with room for <capacity> slots, dropping the tombstones
+  */
+          bool  rehash_p(std::size_t capacity) noexcept {
+          std::size_t l_capacity = capacity_min;
+          while(l_capacity < capacity) {
+              l_capacity <<= 1;
+          }
+          std::size_t l_node_bytes = l_capacity * sizeof(node_type);
+          std::size_t l_ctrl_bytes = l_capacity + group_size - 1;
+          void*       l_data = m_resource->allocate(l_node_bytes + l_ctrl_bytes, alignof(node_type));
+          if(l_data == nullptr) {
+              return false;
+          }
+          node_type*  l_node_list = m_node_list;
+          ctrl_type*  l_ctrl_list = m_ctrl_list;
+          std::size_t l_count = m_capacity;
+          m_node_list = reinterpret_cast<node_type*>(l_data);
+          m_ctrl_list = reinterpret_cast<ctrl_type*>(reinterpret_cast<char*>(l_data) + l_node_bytes);
+          m_capacity  = l_capacity;
+          m_growth    = get_growth_max(l_capacity) - m_size;
+          m_dead      = 0;
+          std::memset(m_ctrl_list, ctrl_empty, l_ctrl_bytes);
+          for(std::size_t i_node = 0; i_node < l_count; i_node++) {
+              if(l_ctrl_list[i_node] >= 0) {
+                  node_type&    l_node = l_node_list[i_node];
+                  std::uint64_t l_mix = get_mix(l_node.key);
+                  std::size_t   l_index = find_free_p(l_mix);
+                  new(m_node_list + l_index) node_type(std::move(l_node));
+                  set_ctrl(l_index, get_h2(l_mix));
+                  l_node.~node_type();
+              }
+          }
+          if(l_node_list != nullptr) {
+              m_resource->deallocate(l_node_list, l_count * sizeof(node_type) + l_count + group_size - 1, alignof(node_type));
+          }
+          return true;
+  }
+
+  /* grow_p()
+     make room for one more entry: reclaim the tombstones if they take up a good part of the table, grow it otherwise
+  */
+  inline  bool  grow_p() noexcept {
+          if(m_capacity && (m_size <= get_growth_max(m_capacity) / 2)) {
+              return rehash_p(m_capacity);
+          }
+          return rehash_p(m_capacity * 2);
+  }
+
+  /* place_p()
+     construct a new entry for <hash> from <args>, known not to be in the table yet
+  */
+  template<typename... Args>
+  inline  node_type* place_p(hash_type hash, Args&&... args) noexcept {
+          std::size_t   l_index = 0;
+          std::uint64_t l_mix   = get_mix(hash);
+          if(m_capacity) {
+              l_index = find_free_p(l_mix);
+          }
+          if((m_capacity == 0) ||
+              ((m_growth == 0) && (m_ctrl_list[l_index] == ctrl_empty))) {
+              if(grow_p() == false) {
+                  return nullptr;
+              }
+              l_index = find_free_p(l_mix);
+          }
+          if(m_ctrl_list[l_index] == ctrl_empty) {
+              --m_growth;
+          } else
+              --m_dead;
+          new(m_node_list + l_index) node_type(hash, std::forward<Args>(args)...);
+          set_ctrl(l_index, get_h2(l_mix));
+          ++m_size;
+          return m_node_list + l_index;
+  }
+
+  inline  void  erase_p(std::size_t index) noexcept {
+          // a slot can be emptied only if no probe sequence ever went past it, that is if no window of <group_size>
+          // slots around it was ever full
+          std::size_t  l_mask   = m_capacity - 1;
+          unsigned int l_after  = group(m_ctrl_list + index).match_empty();
+          unsigned int l_before = group(m_ctrl_list + ((index - group_size) & l_mask)).match_empty();
+          bool         l_empty  = false;
+          if(l_after && l_before) {
+              unsigned int l_run = get_first(l_after) + static_cast<unsigned int>(__builtin_clz(l_before) - (32 - group_size));
+              l_empty = l_run < group_size;
+          }
+          m_node_list[index].~node_type();
+          if(l_empty) {
+              set_ctrl(index, ctrl_empty);
+              ++m_growth;
+          } else {
+              set_ctrl(index, ctrl_deleted);
+              ++m_dead;
+          }
+          --m_size;
+  }
+
+  inline  void  clear_p() noexcept {
+          for(std::size_t i_node = 0; i_node < m_capacity; i_node++) {
+              if(m_ctrl_list[i_node] >= 0) {
+                  m_node_list[i_node].~node_type();
+              }
+          }
+          if(m_capacity) {
+              std::memset(m_ctrl_list, ctrl_empty, m_capacity + group_size - 1);
+          }
+          m_size   = 0;
+          m_growth = get_growth_max(m_capacity);
+          m_dead   = 0;
+  }
+
+  inline  void  free_p() noexcept {
+          clear_p();
+          if(m_node_list != nullptr) {
+              m_resource->deallocate(m_node_list, m_capacity * sizeof(node_type) + m_capacity + group_size - 1, alignof(node_type));
+              m_node_list = nullptr;
+              m_ctrl_list = nullptr;
+          }
+          m_capacity = 0;
+          m_growth   = 0;
+          m_dead     = 0;
+  }
+
+  inline  void  copy_p(const hash_table& copy) noexcept {
+          if(copy.m_size) {
+              if(rehash_p(copy.m_size + copy.m_size / 7 + 1)) {
+                  for(auto i_node = copy.begin(); i_node != copy.end(); i_node++) {
+                      std::uint64_t l_mix = get_mix(i_node->key);
+                      std::size_t   l_index = find_free_p(l_mix);
+                      new(m_node_list + l_index) node_type(*i_node);
+                      set_ctrl(l_index, get_h2(l_mix));
+                      --m_growth;
+                      ++m_size;
+                  }
+              }
+          }
+  }
+
+  inline  void  move_p(hash_table& copy) noexcept {
+          m_node_list = copy.m_node_list;
+          m_ctrl_list = copy.m_ctrl_list;
+          m_capacity  = copy.m_capacity;
+          m_size      = copy.m_size;
+          m_growth    = copy.m_growth;
+          m_dead      = copy.m_dead;
+          copy.m_node_list = nullptr;
+          copy.m_ctrl_list = nullptr;
+          copy.m_capacity  = 0;
+          copy.m_size      = 0;
+          copy.m_growth    = 0;
+          copy.m_dead      = 0;
+  }
+
+  public:
+  inline  hash_table(std::pmr::memory_resource* r = nullptr) noexcept:
+          m_resource(r != nullptr ? r : std::pmr::get_default_resource()),
+          m_node_list(nullptr),
+          m_ctrl_list(nullptr),
+          m_capacity(0),
+          m_size(0),
+          m_growth(0),
+          m_dead(0) {
+  }
+
+  inline  hash_table(const hash_table& copy) noexcept:
+          hash_table(copy.m_resource) {
+          copy_p(copy);
+  }
+
+  inline  hash_table(hash_table&& copy) noexcept:
+          hash_table(copy.m_resource) {
+          move_p(copy);
+  }
+
+  inline  ~hash_table() {
+          free_p();
+  }
+
+  /* find()
+     slot holding <hash>, or nullptr
+  */
+  inline  node_type* find(hash_type hash) const noexcept {
+          std::size_t l_index = find_p(hash);
+          if(l_index < m_capacity) {
+              return m_node_list + l_index;
+          }
+          return nullptr;
+  }
+
+  /* find_match()
+     entry for <hash> for which <match> holds, or nullptr
+  */
+  template<typename Mt>
+  inline  node_type* find_match(hash_type hash, Mt&& match) const noexcept {
+          std::size_t l_index = find_p(hash, match);
+          if(l_index < m_capacity) {
+              return m_node_list + l_index;
+          }
+          return nullptr;
+  }
+
+  /* emplace()
+     construct an entry for <hash> from <args>, unless there already is one; returns the entry for <hash> and whether
+     it was just made, or nullptr if the table could not grow
+  */
+  template<typename... Args>
+  inline  std::pair<node_type*, bool> emplace(hash_type hash, Args&&... args) noexcept {
+          std::size_t l_index = find_p(hash);
+          if(l_index < m_capacity) {
+              return {m_node_list + l_index, false};
+          }
+          node_type* l_node = place_p(hash, std::forward<Args>(args)...);
+          return {l_node, l_node != nullptr};
+  }
+
+  /* emplace_match()
+     as emplace(), for tables where different entries may share a hash: the entry for <hash> is the one for which
+     <match> holds
+  */
+  template<typename Mt, typename... Args>
+  inline  std::pair<node_type*, bool> emplace_match(hash_type hash, Mt&& match, Args&&... args) noexcept {
+          std::size_t l_index = find_p(hash, match);
+          if(l_index < m_capacity) {
+              return {m_node_list + l_index, false};
+          }
+          node_type* l_node = place_p(hash, std::forward<Args>(args)...);
+          return {l_node, l_node != nullptr};
+  }
+
+  /* erase()
+     remove the entry for <hash>, if any
+  */
+  inline  bool  erase(hash_type hash) noexcept {
+          std::size_t l_index = find_p(hash);
+          if(l_index < m_capacity) {
+              erase_p(l_index);
+              return true;
+          }
+          return false;
+  }
+
+  template<typename Mt>
+  inline  bool  erase_match(hash_type hash, Mt&& match) noexcept {
+          std::size_t l_index = find_p(hash, match);
+          if(l_index < m_capacity) {
+              erase_p(l_index);
+              return true;
+          }
+          return false;
+  }
+
+  inline  void  erase(node_type* node) noexcept {
+          if(node != nullptr) {
+              erase_p(static_cast<std::size_t>(node - m_node_list));
+          }
+  }
+
+  /* reserve()
+     make room for <count> entries
+  */
+  inline  bool  reserve(std::size_t count) noexcept {
+          if(count > m_size + m_growth) {
+              return rehash_p(count + count / 7 + 1);
+          }
+          return true;
+  }
+
+  /* collect()
+     rebuild the table in place if one slot in <dead_ratio> or more is a tombstone, so that misses don't have to
+     probe past them
+  */
+  inline  bool  collect() noexcept {
+          if(m_dead && (m_dead * dead_ratio >= m_capacity)) {
+              return rehash_p(m_capacity);
+          }
+          return true;
+  }
+
+  /* compact()
+     rebuild the table without tombstones, to the smallest size that holds its entries
+  */
+  inline  bool  compact() noexcept {
+          if(m_size == 0) {
+              free_p();
+              return true;
+          }
+          return rehash_p(m_size + m_size / 7 + 1);
+  }
+
+  inline  void  clear() noexcept {
+          clear_p();
+  }
+
+  /* get_iterator()
+     iterator pointing at <node>, or end() for nullptr
+  */
+  inline  iterator_type get_iterator(node_type* node) const noexcept {
+          if(node != nullptr) {
+              return iterator_type(m_ctrl_list + (node - m_node_list), m_ctrl_list + m_capacity, node);
+          }
+          return end();
+  }
+
+  inline  iterator_type begin() const noexcept {
+          return iterator_type(m_ctrl_list, m_ctrl_list + m_capacity, m_node_list);
+  }
+
+  inline  iterator_type end() const noexcept {
+          return iterator_type(m_ctrl_list + m_capacity, m_ctrl_list + m_capacity, m_node_list + m_capacity);
+  }
+
+  inline  std::size_t size() const noexcept {
+          return m_size;
+  }
+
+  /* get_resource()
+     memory resource the table takes its storage from
+  */
+  inline  std::pmr::memory_resource* get_resource() const noexcept {
+          return m_resource;
+  }
+
+  inline  std::size_t get_removed_count() const noexcept {
+          return m_dead;
+  }
+
+  inline  std::size_t get_capacity() const noexcept {
+          return m_capacity;
+  }
+
+  inline  bool  empty() const noexcept {
+          return m_size == 0;
+  }
+
+  inline  hash_table& operator=(const hash_table& rhs) noexcept {
+          if(std::addressof(rhs) != this) {
+              free_p();
+              copy_p(rhs);
+          }
+          return *this;
+  }
+
+  inline  hash_table& operator=(hash_table&& rhs) noexcept {
+          if(std::addressof(rhs) != this) {
+              free_p();
+              if(m_resource == rhs.m_resource) {
+                  move_p(rhs);
+              } else
+                  copy_p(rhs);
+          }
+          return *this;
+  }
+};
+
+/*namespace mmi*/ }
+#endif
@@ -24,6 +24,7 @@
 #include <global.h>
 #include <mmi/policy.h>
 #include <mmi/resource.h>
+#include <sys/mman.h>
 
 /* map
  * memory map allocator
@@ -33,10 +34,15 @@ class map: public resource
   int m_desc;
   int m_mode;
   int m_flags;
+  unsigned int m_options;
+  int m_node;
 
   protected:
           void*  remap(void*, std::size_t, std::size_t, std::size_t, bool) noexcept;
           void*  unmap(void*, std::size_t, std::size_t) noexcept;
+          void*  make_map(std::size_t, std::size_t, int) noexcept;
+          void   bind_map(void*, std::size_t, bool) noexcept;
+          std::size_t get_map_size(std::size_t) const noexcept;
 
   virtual void*  do_allocate(std::size_t, std::size_t) noexcept override;
   virtual void   do_deallocate(void*, std::size_t, std::size_t) noexcept override;
@@ -45,10 +51,22 @@ class map: public resource
   public:
   static  constexpr std::size_t alloc_bytes = global::system_page_size;
   static  constexpr std::size_t fixed_bytes = 0u;
+  static  constexpr std::size_t huge_bytes  = 2097152u;
+
+  /* options
+     opt_huge_auto - ask for transparent huge pages on mappings of at least huge_bytes, aligning them accordingly;
+     opt_huge_page - map from the explicit huge page pool (MAP_HUGETLB), falling back to transparent huge pages when
+                     the pool is empty or not configured; sizes are rounded to huge_bytes;
+     opt_populate  - pre-fault the whole mapping at allocation time
+  */
+  static  constexpr unsigned int opt_none      = 0u;
+  static  constexpr unsigned int opt_huge_auto = 1u;
+  static  constexpr unsigned int opt_huge_page = 2u;
+  static  constexpr unsigned int opt_populate  = 4u;
 
   public:
           map() noexcept;
-          map(int, int, int = 0) noexcept;
+          map(int, int, int = 0, unsigned int = opt_none, int = -1) noexcept;
           map(const map&) noexcept;
           map(map&&) noexcept;
   virtual ~map();
@@ -56,6 +74,7 @@ class map: public resource
   virtual void*  reallocate(void*, std::size_t, std::size_t, std::size_t, mmi::fixed) noexcept override;
   virtual void*  reallocate(void*, std::size_t, std::size_t, std::size_t, mmi::expand_throw) override;
   virtual void*  reallocate(void*, std::size_t, std::size_t, std::size_t, ...) noexcept override;
+  virtual bool   discard(void*, std::size_t) noexcept override;
 
   virtual std::size_t get_fixed_size() const noexcept override;
   virtual bool        has_variable_size() const noexcept override;
@@ -68,4 +87,19 @@ class map: public resource
           map&   operator=(const map&) noexcept;
           map&   operator=(map&&) noexcept;
 };
+
+/* map_opt
+   anonymous memory map allocator with options fixed at compile time, for pools and banks, which default construct
+   their resource
+   Options - combination of map::opt_* flags
+   Node    - NUMA node to bind the memory to (preferred, not strict), -1 to leave the placement to the system
+*/
+template<unsigned int Options, int Node = -1>
+class map_opt: public map
+{
+  public:
+  inline  map_opt() noexcept:
+          map(-1, MAP_PRIVATE | MAP_ANONYMOUS, 0, Options, Node) {
+  }
+};
 #endif
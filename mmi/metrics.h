@@ -89,6 +89,15 @@ struct has_realloc_decl: std::conditional<
 {
 };
 
+/* is_relocatable<Xt>
+   determine if objects of type <Xt> can be moved to a different address by copying their bytes, without running
+   their move constructor and destructor; true for trivially copyable types, specialize it to opt in other types
+   which hold no pointers to themselves (or into themselves)
+*/
+template<typename Xt>
+struct is_relocatable: std::is_trivially_copyable<Xt>::type {
+};
+
 /* get_alloc_size()
    returns the number of elements of type <Xt> that an allocator of type <RT> is comfortable
    growing with, as most allocators don't like reserving just a few bytes at a time;
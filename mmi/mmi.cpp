@@ -23,7 +23,13 @@
 #include "metrics.h"
 #include "error.h"
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
 #include <limits>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
 
 static inline bool is_aligned(std::size_t value, std::size_t align) noexcept
 {
@@ -46,29 +52,261 @@ static inline std::size_t get_aligned_value(std::size_t value, std::size_t align
 }
 
 namespace mmi {
+
+static std::atomic<unsigned int> s_thread_slot_next(0u);
+
+unsigned int get_thread_slot() noexcept
+{
+      static thread_local unsigned int s_thread_slot = s_thread_slot_next.fetch_add(1u, std::memory_order_relaxed);
+      return s_thread_slot;
+}
+
 /*namespace mmi*/ }
 
 /* resource
 */
 
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
 static heap       s_heap;
 static resource*  s_default_resource = resource::set_default(nullptr);
 
-      resource::resource() noexcept
+/* resource registry
+   three level radix tree over the numbers of the system pages in a 48 bit address space, mapping each registered
+   page to the resource owning it; lookups are lock free, updates are serialised by a mutex and tree nodes are never
+   freed, so that a reader never sees a node going away under its feet
+*/
+static constexpr int          s_reg_page_bits = __builtin_ctzll(global::system_page_size);
+static constexpr int          s_reg_leaf_bits = 12;
+static constexpr int          s_reg_node_bits = 12;
+static constexpr int          s_reg_root_bits = 48 - s_reg_page_bits - s_reg_node_bits - s_reg_leaf_bits;
+static constexpr std::size_t  s_reg_leaf_size = 1u << s_reg_leaf_bits;
+static constexpr std::size_t  s_reg_node_size = 1u << s_reg_node_bits;
+static constexpr std::size_t  s_reg_root_size = 1u << s_reg_root_bits;
+
+struct reg_leaf {
+  std::atomic<resource*> item[s_reg_leaf_size];
+};
+
+struct reg_node {
+  std::atomic<reg_leaf*> item[s_reg_node_size];
+};
+
+static std::atomic<reg_node*> s_reg_root[s_reg_root_size];
+static std::mutex             s_reg_guard;
+
+/* reg_get_leaf()
+   find the leaf holding the entry for page <page>, making it if <make> is set
+*/
+static reg_leaf* reg_get_leaf(std::uintptr_t page, bool make) noexcept
+{
+      std::size_t l_root_index = page >> (s_reg_node_bits + s_reg_leaf_bits);
+      std::size_t l_node_index = (page >> s_reg_leaf_bits) & (s_reg_node_size - 1);
+      if(l_root_index < s_reg_root_size) {
+          reg_node* l_node = s_reg_root[l_root_index].load(std::memory_order_acquire);
+          if(l_node == nullptr) {
+              if(make == false) {
+                  return nullptr;
+              }
+              l_node = reinterpret_cast<reg_node*>(std::calloc(1, sizeof(reg_node)));
+              if(l_node == nullptr) {
+                  return nullptr;
+              }
+              s_reg_root[l_root_index].store(l_node, std::memory_order_release);
+          }
+          reg_leaf* l_leaf = l_node->item[l_node_index].load(std::memory_order_acquire);
+          if(l_leaf == nullptr) {
+              if(make == false) {
+                  return nullptr;
+              }
+              l_leaf = reinterpret_cast<reg_leaf*>(std::calloc(1, sizeof(reg_leaf)));
+              if(l_leaf == nullptr) {
+                  return nullptr;
+              }
+              l_node->item[l_node_index].store(l_leaf, std::memory_order_release);
+          }
+          return l_leaf;
+      }
+      return nullptr;
+}
+
+/* resource::stats_block
+   allocation counters of a resource, spread over per-thread slots so that threads don't fight over the same cache
+   lines; live bytes are accumulated in the slots and folded into the shared total once they drift by more than
+   s_stats_fold_bytes, which is also when the peak is updated - the peak can therefore miss short spikes smaller than
+   s_stats_fold_bytes times the number of busy slots
+*/
+static constexpr unsigned int  s_stats_slot_count = 64u;
+static constexpr std::int64_t  s_stats_fold_bytes = 65536;
+
+struct resource::stats_block
+{
+  struct alignas(64) slot {
+    std::atomic<std::int64_t>   live_delta;
+    std::atomic<std::uint64_t>  alloc_count;
+    std::atomic<std::uint64_t>  free_count;
+    std::atomic<std::uint64_t>  realloc_count;
+    std::atomic<std::uint64_t>  size_hist[stats_hist_size];
+  };
+
+  std::atomic<std::int64_t>  live;
+  std::atomic<std::int64_t>  peak;
+  slot                       slots[s_stats_slot_count];
+
+  inline  slot& get_slot() noexcept {
+          return slots[mmi::get_thread_slot() % s_stats_slot_count];
+  }
+
+  /* fold()
+     account for <delta> live bytes
+  */
+  inline  void  fold(slot& slot, std::int64_t delta) noexcept {
+          std::int64_t l_delta = slot.live_delta.fetch_add(delta, std::memory_order_relaxed) + delta;
+          if((l_delta >= s_stats_fold_bytes) ||
+              (l_delta <= -s_stats_fold_bytes)) {
+              l_delta = slot.live_delta.exchange(0, std::memory_order_relaxed);
+              std::int64_t l_live = live.fetch_add(l_delta, std::memory_order_relaxed) + l_delta;
+              std::int64_t l_peak = peak.load(std::memory_order_relaxed);
+              while(l_live > l_peak) {
+                  if(peak.compare_exchange_weak(l_peak, l_live, std::memory_order_relaxed)) {
+                      break;
+                  }
+              }
+          }
+  }
+
+  static  unsigned int get_hist_index(std::size_t size) noexcept {
+          if(size) {
+              unsigned int l_index = 63 - __builtin_clzll(size);
+              if(l_index < stats_hist_size) {
+                  return l_index;
+              }
+              return stats_hist_size - 1;
+          }
+          return 0;
+  }
+};
+
+      resource::resource() noexcept:
+      m_stats(nullptr)
 {
 }
 
-      resource::resource(const resource& copy) noexcept
-      
+      resource::resource(const resource&) noexcept:
+      m_stats(nullptr)
 {
 }
 
-      resource::resource(resource&& copy) noexcept
+      resource::resource(resource&&) noexcept:
+      m_stats(nullptr)
 {
 }
 
       resource::~resource()
 {
+      delete m_stats.load(std::memory_order_relaxed);
+}
+
+void  resource::stats_alloc(stats_block* stats, std::size_t size) noexcept
+{
+      auto& l_slot = stats->get_slot();
+      l_slot.alloc_count.fetch_add(1, std::memory_order_relaxed);
+      l_slot.size_hist[stats_block::get_hist_index(size)].fetch_add(1, std::memory_order_relaxed);
+      stats->fold(l_slot, size);
+}
+
+void  resource::stats_free(stats_block* stats, std::size_t size) noexcept
+{
+      auto& l_slot = stats->get_slot();
+      l_slot.free_count.fetch_add(1, std::memory_order_relaxed);
+      stats->fold(l_slot, -static_cast<std::int64_t>(size));
+}
+
+void  resource::stats_realloc(stats_block* stats, std::size_t size, std::size_t new_size) noexcept
+{
+      auto& l_slot = stats->get_slot();
+      l_slot.realloc_count.fetch_add(1, std::memory_order_relaxed);
+      stats->fold(l_slot, static_cast<std::int64_t>(new_size) - static_cast<std::int64_t>(size));
+}
+
+/* set_stats_enabled()
+   start collecting allocation statistics; allocations made before are not accounted for, so their release can make
+   the live byte count lag behind (it is clamped to zero); statistics stay enabled for the lifetime of the resource
+*/
+bool  resource::set_stats_enabled() noexcept
+{
+      if(m_stats.load(std::memory_order_acquire) == nullptr) {
+          stats_block* l_stats = new(std::nothrow) stats_block();
+          stats_block* l_none  = nullptr;
+          if(l_stats == nullptr) {
+              return false;
+          }
+          if(m_stats.compare_exchange_strong(l_none, l_stats, std::memory_order_acq_rel) == false) {
+              delete l_stats;
+          }
+      }
+      return true;
+}
+
+bool  resource::has_stats() const noexcept
+{
+      return m_stats.load(std::memory_order_acquire) != nullptr;
+}
+
+/* get_stats()
+   fold the per-thread counters into a snapshot
+*/
+bool  resource::get_stats(stats& result) const noexcept
+{
+      if(stats_block* l_stats = m_stats.load(std::memory_order_acquire); l_stats != nullptr) {
+          std::int64_t l_live = l_stats->live.load(std::memory_order_relaxed);
+          std::memset(std::addressof(result), 0, sizeof(stats));
+          for(auto& i_slot : l_stats->slots) {
+              l_live += i_slot.live_delta.load(std::memory_order_relaxed);
+              result.alloc_count   += i_slot.alloc_count.load(std::memory_order_relaxed);
+              result.free_count    += i_slot.free_count.load(std::memory_order_relaxed);
+              result.realloc_count += i_slot.realloc_count.load(std::memory_order_relaxed);
+              for(unsigned int i_hist = 0; i_hist < stats_hist_size; i_hist++) {
+                  result.size_hist[i_hist] += i_slot.size_hist[i_hist].load(std::memory_order_relaxed);
+              }
+          }
+          if(l_live < 0) {
+              l_live = 0;
+          }
+          result.live_bytes = l_live;
+          result.peak_bytes = l_stats->peak.load(std::memory_order_relaxed);
+          if(result.peak_bytes < result.live_bytes) {
+              result.peak_bytes = result.live_bytes;
+          }
+          return true;
+      }
+      return false;
+}
+
+/* reset_stats()
+   clear the counters, except for the live bytes; the peak restarts from the current live bytes
+*/
+void  resource::reset_stats() noexcept
+{
+      if(stats_block* l_stats = m_stats.load(std::memory_order_acquire); l_stats != nullptr) {
+          std::int64_t l_live = l_stats->live.load(std::memory_order_relaxed);
+          for(auto& i_slot : l_stats->slots) {
+              l_live += i_slot.live_delta.load(std::memory_order_relaxed);
+              i_slot.alloc_count.store(0, std::memory_order_relaxed);
+              i_slot.free_count.store(0, std::memory_order_relaxed);
+              i_slot.realloc_count.store(0, std::memory_order_relaxed);
+              for(auto& i_hist : i_slot.size_hist) {
+                  i_hist.store(0, std::memory_order_relaxed);
+              }
+          }
+          l_stats->peak.store(l_live, std::memory_order_relaxed);
+      }
 }
 
 void* resource::reallocate(void*, std::size_t, std::size_t, std::size_t, mmi::fixed) noexcept
@@ -90,6 +328,15 @@ void* resource::reallocate(void*, std::size_t, std::size_t, std::size_t, ...) no
       return nullptr;
 }
 
+/* discard()
+   hint that the contents of the given (allocated) region are no longer needed and the memory behind it can be
+   reclaimed; the region stays valid
+*/
+bool  resource::discard(void*, std::size_t) noexcept
+{
+      return false;
+}
+
 resource* resource::get_default() noexcept
 {
       return s_default_resource;
@@ -104,17 +351,50 @@ resource* resource::set_default(resource* resource) noexcept
       return s_default_resource;
 }
 
-resource* resource::get_resource_of(const void*) noexcept
+/* get_resource_of()
+   find the resource that registered the memory at <p>; unregistered memory belongs to the default resource
+*/
+resource* resource::get_resource_of(const void* p) noexcept
 {
+      std::uintptr_t l_page = reinterpret_cast<std::uintptr_t>(p) >> s_reg_page_bits;
+      if(reg_leaf* l_leaf = reg_get_leaf(l_page, false); l_leaf != nullptr) {
+          if(resource* l_resource = l_leaf->item[l_page & (s_reg_leaf_size - 1)].load(std::memory_order_acquire); l_resource != nullptr) {
+              return l_resource;
+          }
+      }
       return s_default_resource;
 }
 
-resource* resource::set_resource_of(const void*, resource* resource) noexcept
+resource* resource::set_resource_of(const void* p, resource* resource) noexcept
 {
-      if(resource == s_default_resource) {
-          return resource;
+      return set_resource_of(p, 1u, resource);
+}
+
+/* set_resource_of()
+   register the system pages spanned by [p, p + size) as belonging to <resource>, or drop them from the registry if
+   <resource> is nullptr; returns <resource>, or nullptr if the registry could not grow
+*/
+resource* resource::set_resource_of(const void* p, std::size_t size, resource* resource) noexcept
+{
+      std::uintptr_t l_head = reinterpret_cast<std::uintptr_t>(p) >> s_reg_page_bits;
+      std::uintptr_t l_tail = (reinterpret_cast<std::uintptr_t>(p) + size + global::system_page_size - 1) >> s_reg_page_bits;
+      std::lock_guard<std::mutex> l_guard(s_reg_guard);
+      while(l_head < l_tail) {
+          std::uintptr_t l_next = (l_head | (s_reg_leaf_size - 1)) + 1;
+          if(l_next > l_tail) {
+              l_next = l_tail;
+          }
+          if(reg_leaf* l_leaf = reg_get_leaf(l_head, resource != nullptr); l_leaf != nullptr) {
+              for(std::uintptr_t i_page = l_head; i_page < l_next; i_page++) {
+                  l_leaf->item[i_page & (s_reg_leaf_size - 1)].store(resource, std::memory_order_release);
+              }
+          } else
+          if(resource != nullptr) {
+              return nullptr;
+          }
+          l_head = l_next;
       }
-      return nullptr;
+      return resource;
 }
 
 resource& resource::operator=(const resource&) noexcept
@@ -150,11 +430,14 @@ resource& resource::operator=(resource&&) noexcept
 
 void* heap::do_allocate(std::size_t size, std::size_t align) noexcept
 {
-      return aligned_alloc(align, size);
+      void* l_data = aligned_alloc(align, get_aligned_value(size, align));
+      stat_alloc(l_data, size);
+      return l_data;
 }
 
-void  heap::do_deallocate(void* p, std::size_t, std::size_t) noexcept
+void  heap::do_deallocate(void* p, std::size_t size, std::size_t) noexcept
 {
+      stat_free(p, size);
       free(p);
 }
 
@@ -168,10 +451,10 @@ void* heap::reallocate(void* p, std::size_t, std::size_t new_size, std::size_t a
       if(p) {
           return nullptr;
       } else
-          return aligned_alloc(align, new_size);
+          return allocate(new_size, align);
 }
 
-void* heap::reallocate(void* p, std::size_t size, std::size_t, std::size_t align, mmi::expand_throw)
+void* heap::reallocate(void* p, std::size_t, std::size_t new_size, std::size_t align, mmi::expand_throw)
 {
       if(p) {
       #ifdef __EXCEPTIONS
@@ -180,18 +463,30 @@ void* heap::reallocate(void* p, std::size_t size, std::size_t, std::size_t align
           return nullptr;
       #endif
       } else
-          return aligned_alloc(align, size);
+          return allocate(new_size, align);
 }
 
-void* heap::reallocate(void* p, std::size_t, std::size_t new_size, std::size_t align, ...) noexcept
+void* heap::reallocate(void* p, std::size_t size, std::size_t new_size, std::size_t align, ...) noexcept
 {
       if(p) {
+          if(align <= alignof(max_align_t)) {
+              void* l_data = realloc(p, new_size);
+              stat_realloc(l_data, size, new_size);
+              return l_data;
+          } else
           if(is_aligned(p, align)) {
-              return realloc(p, new_size);
+              // realloc() doesn't keep extended alignments: move the contents to a new aligned block instead
+              void* l_data = aligned_alloc(align, get_aligned_value(new_size, align));
+              if(l_data != nullptr) {
+                  std::memcpy(l_data, p, size < new_size ? size : new_size);
+                  free(p);
+              }
+              stat_realloc(l_data, size, new_size);
+              return l_data;
           } else
               return nullptr;
       } else
-          return aligned_alloc(align, new_size);
+          return allocate(new_size, align);
 }
 
 std::size_t heap::get_fixed_size() const noexcept
@@ -227,15 +522,19 @@ heap& heap::operator=(heap&& rhs) noexcept
       resource(),
       m_desc(-1),
       m_mode(PROT_READ | PROT_WRITE),
-      m_flags(MAP_PRIVATE | MAP_ANONYMOUS)
+      m_flags(MAP_PRIVATE | MAP_ANONYMOUS),
+      m_options(opt_none),
+      m_node(-1)
 {
 }
 
-      map::map(int desc, int flags, int mode) noexcept:
+      map::map(int desc, int flags, int mode, unsigned int options, int node) noexcept:
       resource(),
       m_desc(desc),
       m_mode(PROT_READ | PROT_WRITE | mode),
-      m_flags(flags)
+      m_flags(flags),
+      m_options(options),
+      m_node(node)
 {
 }
 
@@ -244,7 +543,9 @@ heap& heap::operator=(heap&& rhs) noexcept
       resource(copy),
       m_desc(copy.m_desc),
       m_mode(copy.m_mode),
-      m_flags(copy.m_flags)
+      m_flags(copy.m_flags),
+      m_options(copy.m_options),
+      m_node(copy.m_node)
 {
 }
 
@@ -252,7 +553,9 @@ heap& heap::operator=(heap&& rhs) noexcept
       resource(std::move(copy)),
       m_desc(copy.m_desc),
       m_mode(copy.m_mode),
-      m_flags(copy.m_flags)
+      m_flags(copy.m_flags),
+      m_options(copy.m_options),
+      m_node(copy.m_node)
 {
 }
 
@@ -260,25 +563,126 @@ heap& heap::operator=(heap&& rhs) noexcept
 {
 }
 
-void* map::do_allocate(std::size_t size, std::size_t align) noexcept
+/* make_map()
+   map <size> bytes at an address aligned to <align>
+*/
+void* map::make_map(std::size_t size, std::size_t align, int flags) noexcept
 {
-      if(size) {
-          if(is_aligned(alloc_bytes, align)) {
-              std::size_t l_size = get_aligned_value(size, alloc_bytes);
-              void*       l_data = mmap(nullptr, l_size, m_mode, m_flags, m_desc, 0);
-              if(l_data != MAP_FAILED) {
-                  return l_data;
-              } else
-                  return nullptr;
+      if(is_aligned(alloc_bytes, align)) {
+          void*       l_data = mmap(nullptr, size, m_mode, flags, m_desc, 0);
+          if(l_data != MAP_FAILED) {
+              return l_data;
+          } else
+              return nullptr;
+      } else
+      if(((align & (align - 1)) == 0) &&
+          (flags & MAP_ANONYMOUS)) {
+          // alignment is a power of two larger than a system page: map enough to be able to slide an aligned
+          // region of the requested size in, then unmap the excess at both ends
+          std::size_t l_span = size + align;
+          char*       l_data = reinterpret_cast<char*>(mmap(nullptr, l_span, m_mode, flags & ~MAP_POPULATE, m_desc, 0));
+          if(l_data != MAP_FAILED) {
+              char*   l_head = reinterpret_cast<char*>(get_aligned_value(reinterpret_cast<std::size_t>(l_data), align));
+              char*   l_tail = l_head + size;
+              if(l_head > l_data) {
+                  munmap(l_data, l_head - l_data);
+              }
+              if(l_data + l_span > l_tail) {
+                  munmap(l_tail, l_data + l_span - l_tail);
+              }
+              if(flags & MAP_POPULATE) {
+                  madvise(l_head, size, MADV_POPULATE_WRITE);
+              }
+              return l_head;
           } else
               return nullptr;
       } else
           return nullptr;
 }
 
+/* bind_map()
+   set the preferred NUMA node of a fresh mapping, then pre-fault it if <populate>; binding is best effort: on
+   kernels without NUMA support the memory is placed by the default policy
+*/
+void  map::bind_map(void* p, std::size_t size, bool populate) noexcept
+{
+      if((m_node >= 0) &&
+          (m_node < static_cast<int>(sizeof(unsigned long) * 8))) {
+          unsigned long l_mask = 1ul << m_node;
+          syscall(SYS_mbind, p, size, MPOL_PREFERRED, std::addressof(l_mask), sizeof(l_mask) * 8, 0);
+      }
+      if(populate) {
+          if(madvise(p, size, MADV_POPULATE_WRITE) != 0) {
+              if(m_flags & MAP_ANONYMOUS) {
+                  for(std::size_t i_offset = 0; i_offset < size; i_offset += alloc_bytes) {
+                      reinterpret_cast<volatile char*>(p)[i_offset] = 0;
+                  }
+              }
+          }
+      }
+}
+
+/* get_map_size()
+   size of the mapping actually made for a request of <size> bytes
+*/
+std::size_t map::get_map_size(std::size_t size) const noexcept
+{
+      if(m_options & opt_huge_page) {
+          return get_aligned_value(size, huge_bytes);
+      } else
+          return get_aligned_value(size, alloc_bytes);
+}
+
+void* map::do_allocate(std::size_t size, std::size_t align) noexcept
+{
+      void*  l_data  = nullptr;
+      if(size) {
+          std::size_t l_size  = get_map_size(size);
+          int         l_flags = m_flags;
+          bool        l_huge  = (m_options & (opt_huge_auto | opt_huge_page)) && (l_size >= huge_bytes);
+          bool        l_defer = false;
+          if(m_options & opt_populate) {
+              l_flags |= MAP_POPULATE;
+          }
+          if((l_flags & MAP_POPULATE) &&
+              ((m_node >= 0) || l_huge)) {
+              // pre-faulting is deferred until the memory is bound to its node and marked for huge pages, otherwise
+              // it would be placed by the default policy, in small pages
+              l_flags &= ~MAP_POPULATE;
+              l_defer = true;
+          }
+          if(m_options & opt_huge_page) {
+              // huge page mappings come naturally aligned to huge_bytes
+              l_data = make_map(l_size, align > huge_bytes ? align : alloc_bytes, l_flags | MAP_HUGETLB);
+          }
+          if(l_data == nullptr) {
+              if(l_huge) {
+                  // transparent huge pages are only used for the 2M aligned parts of a mapping
+                  if(align < huge_bytes) {
+                      align = huge_bytes;
+                  }
+              }
+              l_data = make_map(l_size, align, l_flags);
+              if(l_data != nullptr) {
+                  if(l_huge) {
+                      madvise(l_data, l_size, MADV_HUGEPAGE);
+                  }
+              }
+          }
+          if(l_data != nullptr) {
+              bind_map(l_data, l_size, l_defer);
+              set_resource_of(l_data, l_size, this);
+              stat_alloc(l_data, l_size);
+          }
+      }
+      return l_data;
+}
+
 void  map::do_deallocate(void* p, std::size_t size, std::size_t) noexcept
 {
-      munmap(p, size);
+      set_resource_of(p, get_map_size(size), nullptr);
+      stat_free(p, get_map_size(size));
+      munmap(p, get_map_size(size));
 }
 
 bool  map::do_is_equal(const std::pmr::memory_resource&) const noexcept
@@ -288,12 +692,14 @@ bool  map::do_is_equal(const std::pmr::memory_resource&) const noexcept
 
 void* map::reallocate(void* p, std::size_t size, std::size_t new_size, std::size_t align, mmi::fixed) noexcept
 {
-      std::size_t l_size = get_aligned_value(size, alloc_bytes);
+      std::size_t l_size = get_map_size(size);
       if(p) {
           if(l_size < new_size) {
-              std::size_t l_size_new = get_aligned_value(new_size, alloc_bytes);
-              void*       l_data     = mremap(p, l_size, l_size_new, MREMAP_FIXED);
+              std::size_t l_size_new = get_map_size(new_size);
+              void*       l_data     = mremap(p, l_size, l_size_new, 0);
               if(l_data != MAP_FAILED) {
+                  set_resource_of(l_data, l_size_new, this);
+                  stat_realloc(l_data, l_size, l_size_new);
                   return l_data;
               } else
                   return nullptr;
@@ -321,12 +727,26 @@ void* map::reallocate(void* p, std::size_t size, std::size_t new_size, std::size
 
 void* map::reallocate(void* p, std::size_t size, std::size_t new_size, std::size_t align, ...) noexcept
 {
-      std::size_t l_size = get_aligned_value(size, alloc_bytes);
+      std::size_t l_size = get_map_size(size);
       if(p) {
           if(l_size < new_size) {
-              std::size_t l_size_new = get_aligned_value(new_size, alloc_bytes);
+              std::size_t l_size_new = get_map_size(new_size);
               void*       l_data     = mremap(p, l_size, l_size_new, MREMAP_MAYMOVE);
               if(l_data != MAP_FAILED) {
+                  if(l_data != p) {
+                      set_resource_of(p, l_size, nullptr);
+                  }
+                  set_resource_of(l_data, l_size_new, this);
+                  stat_realloc(l_data, l_size, l_size_new);
+                  return l_data;
+              } else
+              if(m_options & opt_huge_page) {
+                  // huge page mappings can't be remapped on all kernels: move the contents over instead
+                  l_data = allocate(new_size, align);
+                  if(l_data != nullptr) {
+                      std::memcpy(l_data, p, l_size);
+                      deallocate(p, size, align);
+                  }
                   return l_data;
               } else
                   return nullptr;
@@ -336,6 +756,14 @@ void* map::reallocate(void* p, std::size_t size, std::size_t new_size, std::size
           return allocate(new_size, align);
 }
 
+bool  map::discard(void* p, std::size_t size) noexcept
+{
+      if(is_aligned(p, alloc_bytes)) {
+          return madvise(p, size, MADV_DONTNEED) == 0;
+      }
+      return false;
+}
+
 std::size_t map::get_fixed_size() const noexcept
 {
       return 0;
@@ -348,7 +776,7 @@ bool  map::has_variable_size() const noexcept
 
 std::size_t map::get_alloc_size(std::size_t size) const noexcept
 {
-      return get_round_value(size, alloc_bytes);
+      return get_map_size(size);
 }
 
 map&  map::operator=(const map& rhs) noexcept
@@ -356,6 +784,8 @@ map&  map::operator=(const map& rhs) noexcept
       resource::operator=(rhs);
       m_mode = rhs.m_mode;
       m_flags = rhs.m_flags;
+      m_options = rhs.m_options;
+      m_node = rhs.m_node;
       return *this;
 }
 
@@ -364,5 +794,7 @@ map&  map::operator=(map&& rhs) noexcept
       resource::operator=(std::move(rhs));
       m_mode = rhs.m_mode;
       m_flags = rhs.m_flags;
+      m_options = rhs.m_options;
+      m_node = rhs.m_node;
       return *this;
 }
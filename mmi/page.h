@@ -36,9 +36,18 @@ namespace mmi {
 template<typename Xt, std::size_t MapSize, std::size_t ArraySize, typename Rt>
 class page: public pool_base<Xt, Rt, fixed>
 {
-  page*  m_prev;
-  page*  m_next;
-  char   m_bitmap[MapSize];
+  public:
+  static constexpr std::size_t map_size = MapSize;
+  static constexpr std::size_t map_bits = 64;
+  static constexpr std::size_t map_words = get_div_ub(map_size, map_bits / 8);
+
+  private:
+  page*          m_prev;
+  page*          m_next;
+  unsigned int   m_map_hint;    /*index of the first map word that might have a free bit*/
+  unsigned int   m_map_free;    /*number of free nodes left in the page*/
+  bool           m_map_cold;    /*page is empty and parked: its memory may have been handed back to the system*/
+  std::uint64_t  m_bitmap[map_words];
 
   static_assert(ArraySize > 0, "ArraySize must be greater than 0.");
 
@@ -47,16 +56,16 @@ class page: public pool_base<Xt, Rt, fixed>
   using  node_type     = typename base_type::node_type;
   using  resource_type = typename base_type::resource_type;
 
-  static constexpr std::size_t map_size = MapSize;
   static constexpr std::size_t node_size = sizeof(node_type);
   static constexpr std::size_t array_size = ArraySize;
 
   private:
   /* get_page_bytes()
-     size of a page object, in bytes
+     size of the region reserved at the beginning of each allocation: it holds the next page object, followed by a
+     pointer back to the page that owns the allocation
   */
   constexpr std::size_t get_page_bytes() const noexcept {
-          return sizeof(page);
+          return sizeof(page) + sizeof(page*);
   }
 
   /* get_page_nodes()
@@ -101,17 +110,48 @@ class page: public pool_base<Xt, Rt, fixed>
               return e_max;
   }
 
+  /* get_page_align()
+     smallest power of two that spans all the nodes a page can hold; if the page memory is allocated at this
+     alignment, the page owning a node can be found by masking the node address
+  */
+  constexpr std::size_t get_page_align(std::size_t e_min, std::size_t e_max) const noexcept {
+          std::size_t l_min_bytes = get_min_alloc(e_min) * node_size;
+          std::size_t l_max_bytes = get_max_alloc(e_max) * node_size;
+          std::size_t l_align     = global::system_page_size;
+          while((l_align < l_min_bytes) ||
+              (l_align < l_max_bytes)) {
+              l_align <<= 1;
+          }
+          return l_align;
+  }
+
+  /* get_node_capacity()
+     number of nodes (or node arrays, if ArraySize > 1) that the page is able to track in its map
+  */
+  inline  std::size_t get_node_capacity() const noexcept {
+          std::size_t l_count = 0;
+          if constexpr (map_size > 0) {
+              if(base_type::m_last > base_type::m_head) {
+                  l_count = (base_type::m_last - base_type::m_head) / array_size;
+                  if(l_count > map_size * 8) {
+                      l_count = map_size * 8;
+                  }
+              }
+          }
+          return l_count;
+  }
+
   protected:
   /* map_get_bit()
      get the bit in the map corresponding to the given node pointer
   */
-          bool map_get_bit(node_type* node, unsigned int& byte, unsigned int& bit) noexcept {
+          bool map_get_bit(node_type* node, unsigned int& word, unsigned int& bit) noexcept {
           unsigned int l_index;
           if(node >= base_type::m_head) {
               if(node < base_type::m_last) {
                   l_index =(node - base_type::m_head) / array_size;
-                  byte    = l_index / 8;
-                  bit     = l_index % 8;
+                  word    = l_index / map_bits;
+                  bit     = l_index % map_bits;
                   return true;
               }
           }
@@ -121,10 +161,10 @@ class page: public pool_base<Xt, Rt, fixed>
   /* map_get_mask()
      get the mask in the map corresponding to the given node pointer
   */
-          bool map_get_mask(node_type* node, unsigned int& byte, unsigned int& mask) noexcept {
+          bool map_get_mask(node_type* node, unsigned int& word, std::uint64_t& mask) noexcept {
           unsigned int l_bit;
-          if(map_get_bit(node, byte, l_bit)) {
-              mask = 1 << l_bit;
+          if(map_get_bit(node, word, l_bit)) {
+              mask = std::uint64_t(1) << l_bit;
               return true;
           }
           return false;
@@ -133,8 +173,8 @@ class page: public pool_base<Xt, Rt, fixed>
   /* map_get_node()
      get the node pointer corresponding to the given bit in the map
   */
-          node_type*  map_get_node(unsigned int byte, unsigned int bit) noexcept {
-          node_type*  l_result = base_type::m_head + ((byte * 8) + bit) * array_size;
+          node_type*  map_get_node(unsigned int word, unsigned int bit) noexcept {
+          node_type*  l_result = base_type::m_head + ((word * map_bits) + bit) * array_size;
           if(l_result < base_type::m_last) {
               return l_result;
           }
@@ -146,10 +186,13 @@ class page: public pool_base<Xt, Rt, fixed>
   */
   inline  node_type*  map_set_node(node_type* node) noexcept {
           if constexpr (map_size > 0) {
-              unsigned int l_byte = 0;
-              unsigned int l_mask = 0;
-              if(map_get_mask(node, l_byte, l_mask)) {
-                  m_bitmap[l_byte] |= l_mask;
+              unsigned int  l_word = 0;
+              std::uint64_t l_mask = 0;
+              if(map_get_mask(node, l_word, l_mask)) {
+                  if((m_bitmap[l_word] & l_mask) == 0) {
+                      m_bitmap[l_word] |= l_mask;
+                      m_map_free--;
+                  }
                   return node;
               }
           }
@@ -161,11 +204,17 @@ class page: public pool_base<Xt, Rt, fixed>
   */
   inline  node_type*  map_clear_node(node_type* node) noexcept {
           if constexpr (map_size > 0) {
-              unsigned int l_byte = 0;
-              unsigned int l_mask = 0;
-              if(map_get_mask(node, l_byte, l_mask)) {
-                  m_bitmap[l_byte] &= ~l_mask;
-                  return node;
+              unsigned int  l_word = 0;
+              std::uint64_t l_mask = 0;
+              if(map_get_mask(node, l_word, l_mask)) {
+                  if(m_bitmap[l_word] & l_mask) {
+                      m_bitmap[l_word] &= ~l_mask;
+                      m_map_free++;
+                      if(l_word < m_map_hint) {
+                          m_map_hint = l_word;
+                      }
+                      return node;
+                  }
               }
           }
           return nullptr;
@@ -237,22 +286,35 @@ class page: public pool_base<Xt, Rt, fixed>
   inline  page() noexcept {
   }
 
-  inline  page(std::size_t  e_min = 0, std::size_t  e_max = std::numeric_limits<unsigned int>::max()) noexcept:
-          base_type(get_min_alloc(e_min * array_size), get_max_alloc(e_max * array_size)),
+  inline  page(std::size_t  e_min = 0, std::size_t  e_max = std::numeric_limits<unsigned int>::max(), bool align = false) noexcept:
+          base_type(
+              get_min_alloc(e_min * array_size),
+              get_max_alloc(e_max * array_size),
+              align ? get_page_align(e_min * array_size, e_max * array_size) : 0u
+          ),
           m_prev(nullptr),
-          m_next(nullptr) {
+          m_next(nullptr),
+          m_map_hint(0),
+          m_map_free(0),
+          m_map_cold(false) {
           if constexpr (map_size > 0) {
-              std::memset(m_bitmap, 0, map_size);
+              std::memset(m_bitmap, 0, sizeof(m_bitmap));
           }
           //reserve space for the next page at the beginning of the allocated region
           if(base_type::m_base) {
+              *get_owner_ptr(base_type::m_base) = this;
               base_type::m_head += get_page_nodes();
               base_type::m_tail += get_page_nodes();
           }
+          m_map_free = get_node_capacity();
   }
 
   inline  page(page* root) noexcept:
-          page(root->m_resource, root->m_count_max, root->m_count_max) {
+          page(
+              (root->m_count_min - root->get_page_nodes()) / array_size,
+              root->m_count_max / array_size,
+              root->m_align > alignof(node_type)
+          ) {
   }
 
           page(const page&) noexcept = delete;
@@ -269,23 +331,15 @@ class page: public pool_base<Xt, Rt, fixed>
           // free the allocated nodes
           // when the page is mapped, lookup allocated nodes in the map and free all found
           if constexpr (map_size > 0) {
-              node_type*   l_node;
-              unsigned int l_byte = 0;
-              unsigned int l_bit  = 0;
-              while(m_bitmap[l_byte] & (1 << l_bit)) {
-                  l_node = map_get_node(l_byte, l_bit);
-                  if(l_node) {
-                      free_node(l_node);
-                      if(l_bit < 7) {
-                          l_bit++;
-                      } else
-                      if(l_byte < map_size - 1) {
-                          l_bit = 0;
-                          l_byte++;
-                      } else
-                          break;
-                  } else
-                      break;
+              for(unsigned int l_word = 0; l_word < map_words; l_word++) {
+                  std::uint64_t l_used = m_bitmap[l_word];
+                  while(l_used) {
+                      node_type* l_node = map_get_node(l_word, __builtin_ctzll(l_used));
+                      if(l_node) {
+                          free_node(l_node);
+                      }
+                      l_used &= l_used - 1;
+                  }
               }
           }
   }
@@ -298,15 +352,18 @@ class page: public pool_base<Xt, Rt, fixed>
   }
   
   /* find()
+     if node is given, return it if it is allocated within this page, nullptr otherwise;
+     if node is nullptr, look up a free slot: the map is scanned a word at a time, starting with the first word
+     that might have a free bit; pages with no free nodes left are rejected without a scan
   */
           node_type*   find(node_type* node, node_type*& hint) noexcept {
-          unsigned int l_byte = 0;
+          unsigned int l_word = 0;
           unsigned int l_bit  = 0;
           if(node) {
               // find used node
               // return node if allocated, nullptr otherwise
-              if(map_get_bit(node, l_byte, l_bit) == true) {
-                  if(m_bitmap[l_byte] & (1 << l_bit)) {
+              if(map_get_bit(node, l_word, l_bit) == true) {
+                  if(m_bitmap[l_word] & (std::uint64_t(1) << l_bit)) {
                       return hint = node;
                   } else
                       return hint = nullptr;
@@ -315,22 +372,55 @@ class page: public pool_base<Xt, Rt, fixed>
           } else
           if constexpr (map_size > 0) {
               // find free node
-              map_get_bit(hint, l_byte, l_bit);
-              while(m_bitmap[l_byte] & (1 << l_bit)) {
-                  if(l_bit < 8) {
-                      l_bit++;
-                  } else
-                  if(l_byte < map_size - 1) {
-                      l_bit = 0;
-                      l_byte++;
-                  } else
-                      return hint = nullptr;
+              if(m_map_free) {
+                  for(l_word = m_map_hint; l_word < map_words; l_word++) {
+                      if(std::uint64_t l_free = ~m_bitmap[l_word]; l_free) {
+                          m_map_hint = l_word;
+                          return hint = map_get_node(l_word, __builtin_ctzll(l_free));
+                      }
+                  }
+                  m_map_hint = map_words;
               }
-              return hint = map_get_node(l_byte, l_bit);
+              return hint = nullptr;
           }
           return nullptr;
   }
 
+  /* get_owner_ptr()
+     location of the pointer to the page owning the memory region that starts at <base>
+  */
+  static  page** get_owner_ptr(void* base) noexcept {
+          return reinterpret_cast<page**>(reinterpret_cast<char*>(base) + sizeof(page));
+  }
+
+  /* discard()
+     let the resource reclaim the memory behind the nodes of an empty page; the page stays valid and usable
+  */
+  inline  bool discard() noexcept {
+          if(is_empty()) {
+              auto  l_head = reinterpret_cast<std::uintptr_t>(base_type::m_head);
+              auto  l_tail = reinterpret_cast<std::uintptr_t>(base_type::m_last);
+              l_head = get_round_value(l_head, global::system_page_size);
+              l_tail = l_tail - (l_tail % global::system_page_size);
+              if(l_tail > l_head) {
+                  return base_type::m_resource.discard(reinterpret_cast<void*>(l_head), l_tail - l_head);
+              }
+          }
+          return false;
+  }
+
+  inline  bool is_empty() const noexcept {
+          return m_map_free == get_node_capacity();
+  }
+
+  inline  bool has_free() const noexcept {
+          return m_map_free;
+  }
+
+  inline  std::size_t get_free_count() const noexcept {
+          return m_map_free;
+  }
+
   inline  node_type*  get_tail() const noexcept {
           if(base_type::m_tail > base_type::m_head) {
               return base_type::m_tail;
@@ -227,25 +227,70 @@ class pool<char, Rt>
           return p_raw;
   }
 
+  /* raw_get()
+     get <size> uninitialised bytes aligned to <align> (a power of two), without a terminating zero
+  */
+  inline  char*  raw_get(std::size_t size, std::size_t align = alignof(max_align_t)) noexcept {
+          if(m_base != nullptr) {
+              auto  l_used = reinterpret_cast<std::uintptr_t>(m_used);
+              char* p_raw  = m_used + (((l_used + align - 1) & ~(align - 1)) - l_used);
+              if((p_raw <= m_last) &&
+                  (size <= static_cast<std::size_t>(m_last - p_raw))) {
+                  m_used = p_raw + size;
+                  m_next = m_used;
+                  return p_raw;
+              }
+          }
+          return nullptr;
+  }
+
+  inline  char*  get_base() const noexcept {
+          return m_base;
+  }
+
+  inline  std::size_t get_used_size() const noexcept {
+          return m_used - m_base;
+  }
+
+  inline  std::size_t get_free_size() const noexcept {
+          return m_last - m_used;
+  }
+
+  inline  std::size_t get_size() const noexcept {
+          return m_size;
+  }
+
   inline  void   restore(const char*& position) noexcept {
           if((position != nullptr) &&
               ((position >= m_base) && (position <= m_last))) {
-              m_used = position;
+              m_used = m_base + (position - m_base);
+              m_next = m_used;
               position = nullptr;
           }
   }
 
+  /* reserve()
+     make sure the pool holds at least <size> bytes; the pool can only be moved to a larger buffer while it is empty,
+     as the strings handed out so far point into the current one
+  */
   inline  bool   reserve(std::size_t size) noexcept {
+          if(size <= m_size) {
+              return true;
+          }
+          if(m_used != m_base) {
+              return false;
+          }
           void*  p_alloc = m_resource.allocate(size, alignof(max_align_t));
           if(p_alloc != nullptr) {
-              m_base = reinterpret_cast<char*>(p_alloc);
               if(m_base != nullptr) {
-                  m_used = m_base;
-                  m_next = m_base;
-                  m_last = m_base + size;
-                  m_size = size;
-                  return true;
+                  m_resource.deallocate(m_base, m_size, alignof(max_align_t));
               }
+              m_base = reinterpret_cast<char*>(p_alloc);
+              m_used = m_base;
+              m_next = m_base;
+              m_last = m_base + size;
+              m_size = size;
+              return true;
           }
           return false;
   }
@@ -51,6 +51,8 @@ class pool_base
       std::is_destructible<node_type>::value &&
       (std::is_trivially_destructible<node_type>::value == false);
 
+  static constexpr bool is_node_relocatable  = is_relocatable<node_type>::value;
+
   static constexpr bool is_resource_static    = get_fixed_size<resource_type, node_type>();
   static constexpr bool is_resource_resizable = get_resizable<resource_type, policy_type>();
 
@@ -69,7 +71,7 @@ class pool_base
   protected:
   template<typename... Args>
   inline  node_type* make_node(node_type* node, Args&&... args) noexcept {
-          if constexpr (is_node_constructible && std::is_constructible<node_type, Args...>::value) {
+          if constexpr ((is_node_constructible || sizeof...(Args)) && std::is_constructible<node_type, Args...>::value) {
               new(node) node_type(std::forward<Args>(args)...);
           }
           return node;
@@ -141,13 +143,13 @@ class pool_base
                   // resource allows realloc()
                   // if the nodes are constructible c++ objects, reallocation is *not* performed
                   // directly (violates the c++ principles), but instead replaced by a new
-                  // allocation, followed by a move.
-                  // otherwise, for primitive types and pure data nodes realloc() works as follows:
+                  // allocation, followed by a move - unless the type is declared relocatable.
+                  // otherwise, for primitive types, pure data and relocatable nodes realloc() works as follows:
                   // - if not previously allocated, simply alloc();
                   // - if empty, don't realloc(), simply alloc() - that saves an expensive and
                   //   unnecessary move operation with garbage data;
                   // - proceed as normal otherwise
-                  if constexpr (is_node_constructible) {
+                  if constexpr (is_node_constructible && (is_node_relocatable == false)) {
                       l_size_next = get_alloc_size<resource_type, node_type>(size);
                   } else
                   if(m_base == nullptr) {
@@ -165,6 +167,8 @@ class pool_base
                           }
                           l_base = m_base;
                           m_base = l_copy_ptr;
+                          m_head = l_copy_ptr + (m_head - l_base);
+                          m_tail = l_copy_ptr + (m_tail - l_base);
                           m_last = l_copy_ptr + l_size_new;
                           m_size = l_size_exp;
                       } else
@@ -327,10 +331,10 @@ class pool_base
   }
 
   public:
-  /**/    pool_base(std::size_t e_min = 0u, std::size_t e_max = std::numeric_limits<unsigned int>::max()) noexcept:
+  /**/    pool_base(std::size_t e_min = 0u, std::size_t e_max = std::numeric_limits<unsigned int>::max(), std::size_t align = 0u) noexcept:
           m_resource(),
           m_policy(),
-          m_align(alignof(node_type)),
+          m_align(align > alignof(node_type) ? align : alignof(node_type)),
           m_size(0),
           m_count_min(0),
           m_count_max(0),
@@ -23,13 +23,66 @@
 **/
 #include <global.h>
 #include <memory_resource>
+#include <atomic>
 
 class resource: public std::pmr::memory_resource
 {
+  public:
+  static  constexpr unsigned int stats_hist_size = 40u;
+
+  /* stats
+     snapshot of the allocation statistics of a resource, in bytes as handed out by the resource (after rounding);
+     size_hist counts allocations by the log2 of their size
+  */
+  struct stats {
+    std::size_t live_bytes;
+    std::size_t peak_bytes;
+    std::size_t alloc_count;
+    std::size_t free_count;
+    std::size_t realloc_count;
+    std::size_t size_hist[stats_hist_size];
+  };
+
+  private:
+  struct stats_block;
+  std::atomic<stats_block*> m_stats;
+
+  private:
+          void   stats_alloc(stats_block*, std::size_t) noexcept;
+          void   stats_free(stats_block*, std::size_t) noexcept;
+          void   stats_realloc(stats_block*, std::size_t, std::size_t) noexcept;
+
   protected:
   virtual void*  do_allocate(std::size_t, std::size_t) noexcept override = 0;
   virtual bool   do_is_equal(const std::pmr::memory_resource&) const noexcept override = 0;
 
+  /* stat_*()
+     let the implementations record their allocations; these reduce to a test when statistics are not enabled
+  */
+  inline  void   stat_alloc(void* p, std::size_t size) noexcept {
+          if(stats_block* l_stats = m_stats.load(std::memory_order_acquire); l_stats != nullptr) {
+              if(p != nullptr) {
+                  stats_alloc(l_stats, size);
+              }
+          }
+  }
+
+  inline  void   stat_free(void* p, std::size_t size) noexcept {
+          if(stats_block* l_stats = m_stats.load(std::memory_order_acquire); l_stats != nullptr) {
+              if(p != nullptr) {
+                  stats_free(l_stats, size);
+              }
+          }
+  }
+
+  inline  void   stat_realloc(void* p, std::size_t size, std::size_t new_size) noexcept {
+          if(stats_block* l_stats = m_stats.load(std::memory_order_acquire); l_stats != nullptr) {
+              if(p != nullptr) {
+                  stats_realloc(l_stats, size, new_size);
+              }
+          }
+  }
+
   public:
           resource() noexcept;
           resource(const resource&) noexcept;
@@ -39,6 +92,12 @@ class resource: public std::pmr::memory_resource
   virtual void*  reallocate(void*, std::size_t, std::size_t, std::size_t, mmi::fixed) noexcept;
   virtual void*  reallocate(void*, std::size_t, std::size_t, std::size_t, mmi::expand_throw);
   virtual void*  reallocate(void*, std::size_t, std::size_t, std::size_t, ...) noexcept;
+  virtual bool   discard(void*, std::size_t) noexcept;
+
+          bool   set_stats_enabled() noexcept;
+          bool   has_stats() const noexcept;
+          bool   get_stats(stats&) const noexcept;
+          void   reset_stats() noexcept;
 
   inline  bool        has_fixed_size() const noexcept {
           return get_fixed_size();
@@ -52,6 +111,7 @@ class resource: public std::pmr::memory_resource
   static  resource*   set_default(resource*) noexcept;
   static  resource*   get_resource_of(const void*) noexcept;
   static  resource*   set_resource_of(const void*, resource*) noexcept;
+  static  resource*   set_resource_of(const void*, std::size_t, resource*) noexcept;
   
           resource&   operator=(const resource&) noexcept;
           resource&   operator=(resource&&) noexcept;
@@ -0,0 +1,213 @@
+#ifndef mmi_slab_h
+#define mmi_slab_h
+/** 
+    Copyright (c) 2024, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include "bank.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace mmi {
+
+/* slab
+   thread safe memory bank
+   each thread allocates from and frees into a small magazine of nodes; magazines are refilled from and drained into
+   a shared bank in batches, so the bank lock is only taken once every few operations
+   Xt - data type
+   PageSize - minumum number of elements a page can hold (default: 256)
+   ArraySize - array size (default: 1)
+   Rt - resource type (default: heap)
+*/
+template<typename Xt, std::size_t PageSize, std::size_t ArraySize, typename Rt>
+class slab
+{
+  public:
+  using  bank_type = bank<Xt, PageSize, ArraySize, Rt>;
+  using  node_type = typename bank_type::node_type;
+
+  static constexpr std::size_t  array_size = ArraySize;
+  static constexpr unsigned int magazine_size = global::cache_small_max;
+  static constexpr unsigned int magazine_fill = magazine_size / 2;
+  static constexpr unsigned int magazine_count = global::cache_small_max * 2;
+
+  static constexpr bool is_node_constructible =
+      std::is_trivial<node_type>::value == false;
+
+  static constexpr bool is_node_destructible =
+      std::is_destructible<node_type>::value &&
+      (std::is_trivially_destructible<node_type>::value == false);
+
+  private:
+  /* magazine
+     per-thread node cache; threads are mapped onto magazines by their slot number, so magazines are only contended
+     when there are more threads than magazines
+  */
+  struct alignas(64) magazine
+  {
+    std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+    unsigned int     m_count = 0;
+    node_type*       m_list[magazine_size];
+  };
+
+  private:
+  std::mutex    m_bank_guard;
+  bank_type     m_bank;
+  magazine      m_cache[magazine_count];
+
+  private:
+  inline  magazine& get_magazine() noexcept {
+          return m_cache[get_thread_slot() % magazine_count];
+  }
+
+  inline  void  lock(magazine& cache) noexcept {
+          while(cache.m_lock.test_and_set(std::memory_order_acquire)) {
+              std::this_thread::yield();
+          }
+  }
+
+  inline  void  unlock(magazine& cache) noexcept {
+          cache.m_lock.clear(std::memory_order_release);
+  }
+
+  /* refill()
+     move a batch of nodes from the bank into the magazine
+  */
+          void  refill(magazine& cache) noexcept {
+          std::lock_guard<std::mutex> l_bank_guard(m_bank_guard);
+          while(cache.m_count < magazine_fill) {
+              node_type* l_node = m_bank.acquire();
+              if(l_node == nullptr) {
+                  break;
+              }
+              cache.m_list[cache.m_count++] = l_node;
+          }
+  }
+
+  /* drain()
+     move nodes from the magazine back into the bank, until <count> nodes are left
+  */
+          void  drain(magazine& cache, unsigned int count) noexcept {
+          std::lock_guard<std::mutex> l_bank_guard(m_bank_guard);
+          while(cache.m_count > count) {
+              m_bank.release(cache.m_list[--cache.m_count]);
+          }
+  }
+
+  template<typename... Args>
+  inline  node_type* make_node(node_type* node, Args&&... args) noexcept {
+          if constexpr ((is_node_constructible || sizeof...(Args)) && std::is_constructible<node_type, Args...>::value) {
+              for(std::size_t l_index = 0; l_index < array_size; l_index++) {
+                  new(node + l_index) node_type(std::forward<Args>(args)...);
+              }
+          }
+          return node;
+  }
+
+  inline  void  free_node(node_type* node) noexcept {
+          if constexpr (is_node_destructible) {
+              for(std::size_t l_index = array_size; l_index > 0; l_index--) {
+                  node[l_index - 1].~node_type();
+              }
+          }
+  }
+
+  public:
+  inline  slab(bool align = false) noexcept:
+          m_bank_guard(),
+          m_bank(align) {
+  }
+
+          slab(const slab&) noexcept = delete;
+          slab(slab&&) noexcept = delete;
+
+  inline  ~slab() {
+          // nodes held in magazines are reserved, but not constructed - they have to be released before the bank
+          // goes down, otherwise it would attempt to destroy them
+          for(auto& i_cache : m_cache) {
+              drain(i_cache, 0);
+          }
+  }
+
+  template<typename... Args>
+          node_type* emplace(Args&&... args) noexcept {
+          node_type* l_node  = nullptr;
+          magazine&  l_cache = get_magazine();
+          lock(l_cache);
+          if(l_cache.m_count == 0) {
+              refill(l_cache);
+          }
+          if(l_cache.m_count) {
+              l_node = l_cache.m_list[--l_cache.m_count];
+          }
+          unlock(l_cache);
+          if(l_node) {
+              return make_node(l_node, std::forward<Args>(args)...);
+          }
+          return nullptr;
+  }
+
+  /* remove()
+     destroy a node obtained from emplace() and return it to the calling thread's magazine
+  */
+          node_type* remove(node_type* node) noexcept {
+          if(node) {
+              magazine&  l_cache = get_magazine();
+              free_node(node);
+              lock(l_cache);
+              if(l_cache.m_count == magazine_size) {
+                  drain(l_cache, magazine_fill);
+              }
+              l_cache.m_list[l_cache.m_count++] = node;
+              unlock(l_cache);
+          }
+          return node;
+  }
+
+  /* trim()
+     return all cached nodes to the shared bank, then release the empty pages at the end of the bank
+  */
+          unsigned int trim() noexcept {
+          for(auto& i_cache : m_cache) {
+              lock(i_cache);
+              drain(i_cache, 0);
+              unlock(i_cache);
+          }
+          std::lock_guard<std::mutex> l_bank_guard(m_bank_guard);
+          return m_bank.trim();
+  }
+
+  inline  void  set_page_spare(unsigned int count) noexcept {
+          std::lock_guard<std::mutex> l_bank_guard(m_bank_guard);
+          m_bank.set_page_spare(count);
+  }
+
+  inline  void  set_page_trim(unsigned int count) noexcept {
+          std::lock_guard<std::mutex> l_bank_guard(m_bank_guard);
+          m_bank.set_page_trim(count);
+  }
+
+          slab& operator=(const slab&) noexcept = delete;
+          slab& operator=(slab&&) noexcept = delete;
+};
+
+/*namespace mmi*/ }
+#endif
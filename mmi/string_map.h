@@ -0,0 +1,377 @@
+#ifndef mmi_string_map_h
+#define mmi_string_map_h
+/** 
+    Copyright (c) 2024, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include "hash_table.h"
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+
+namespace mmi {
+
+/* string_map
+   map of strings to values, over an open addressing hash_table; unlike hash_map, the full key is kept next to its
+   hash and checked on every hash match, so colliding keys stay distinct. Lookups take the key as a string_view, a
+   pointer and length or a C string and hash it in place, without building a std::string or a hasher object.
+   Short keys are kept in the node, longer ones in memory taken from the map's resource, like the table itself.
+   Xt - value type
+   Ht - hash type (default: std::uint64_t)
+*/
+template<typename Xt, typename Ht = std::uint64_t>
+class string_map
+{
+  public:
+  using  key_type   = std::string_view;
+  using  value_type = typename std::remove_cv<Xt>::type;
+  using  hash_type  = Ht;
+
+  /* entry
+     key and value of a map node; the node itself is keyed on the hash of the key. Keys of up to name_max bytes are
+     kept in place, longer ones are copied into memory from <resource>; if that can't be had, the entry is left
+     without a key, see is_valid()
+  */
+  struct entry
+  {
+    static constexpr std::size_t name_max = 16;
+
+    private:
+    std::pmr::memory_resource* m_resource;
+    std::size_t m_size;
+    union {
+      char*     m_ptr;
+      char      m_buf[name_max];
+    };
+
+    public:
+    value_type  value;
+
+    public:
+    template<typename... Args>
+    inline  entry(key_type key, std::pmr::memory_resource* resource, Args&&... args) noexcept:
+            m_resource(resource),
+            m_size(key.size()),
+            value(std::forward<Args>(args)...) {
+            char* l_data = m_buf;
+            if(m_size > name_max) {
+                l_data = m_ptr = reinterpret_cast<char*>(m_resource->allocate(m_size, 1));
+            }
+            if(l_data != nullptr) {
+                std::memcpy(l_data, key.data(), m_size);
+            }
+    }
+
+    /* entry()
+       copy of <copy>, with the key taken from the same resource; string_map itself copies entries through insert,
+       so that keys come from its own resource
+    */
+    inline  entry(const entry& copy) noexcept:
+            entry(copy.get_name(), copy.m_resource, copy.value) {
+    }
+
+    inline  entry(entry&& copy) noexcept:
+            m_resource(copy.m_resource),
+            m_size(copy.m_size),
+            value(std::move(copy.value)) {
+            if(m_size > name_max) {
+                m_ptr = copy.m_ptr;
+                copy.m_ptr = nullptr;
+                copy.m_size = 0;
+            } else
+                std::memcpy(m_buf, copy.m_buf, m_size);
+    }
+
+    inline  ~entry() {
+            if(m_size > name_max) {
+                if(m_ptr != nullptr) {
+                    m_resource->deallocate(m_ptr, m_size, 1);
+                }
+            }
+    }
+
+    inline  key_type get_name() const noexcept {
+            if(m_size > name_max) {
+                return key_type(m_ptr, m_size);
+            }
+            return key_type(m_buf, m_size);
+    }
+
+    /* is_valid()
+       check if the key could be stored
+    */
+    inline  bool is_valid() const noexcept {
+            return (m_size <= name_max) || (m_ptr != nullptr);
+    }
+
+            entry& operator=(const entry&) noexcept = delete;
+            entry& operator=(entry&&) noexcept = delete;
+  };
+
+  using  base_type  = hash_table<Ht, entry>;
+  using  node_type  = typename base_type::node_type;
+
+  public:
+  using  iterator_type = typename base_type::iterator_type;
+  using  result_type   = node_type*;
+
+  private:
+  base_type     m_table;
+  unsigned int  m_replace_bit:1; /*whether to replace an already existing element or fail*/
+  unsigned int  m_remove_bit:1;  /*whether to reclaim the tombstones left by removal as they pile up, or only on compact()*/
+
+  private:
+  /* get_hash()
+     one pass multiply and xorshift hash, eight bytes at a time; the last word is read so that it ends with the key,
+     overlapping the one before it, and keys shorter than a word are read in two halves, so that there are only
+     fixed size loads
+  */
+  static  hash_type get_hash(const char* data, std::size_t size) noexcept {
+          std::uint64_t l_hash = 0x9e3779b97f4a7c15ull ^ (size * 0xff51afd7ed558ccdull);
+          std::uint64_t l_word = 0;
+          if(size > 8) {
+              const char* l_last = data + size - 8;
+              while(data < l_last) {
+                  std::memcpy(std::addressof(l_word), data, 8);
+                  l_hash  = (l_hash ^ l_word) * 0xbf58476d1ce4e5b9ull;
+                  l_hash ^= l_hash >> 31;
+                  data += 8;
+              }
+              std::memcpy(std::addressof(l_word), l_last, 8);
+          } else
+          if(size >= 4) {
+              std::uint32_t l_head;
+              std::uint32_t l_tail;
+              std::memcpy(std::addressof(l_head), data, 4);
+              std::memcpy(std::addressof(l_tail), data + size - 4, 4);
+              l_word = (static_cast<std::uint64_t>(l_head) << 32) | l_tail;
+          } else
+          if(size) {
+              l_word = (static_cast<std::uint64_t>(static_cast<unsigned char>(data[0])) << 16) |
+                  (static_cast<std::uint64_t>(static_cast<unsigned char>(data[size >> 1])) << 8) |
+                  static_cast<unsigned char>(data[size - 1]);
+          }
+          l_hash  = (l_hash ^ l_word) * 0x94d049bb133111ebull;
+          l_hash ^= l_hash >> 31;
+          l_hash *= 0xbf58476d1ce4e5b9ull;
+          l_hash ^= l_hash >> 32;
+          return static_cast<hash_type>(l_hash);
+  }
+
+  /* get_match()
+     predicate telling whether a node with a matching hash is the one for <key>
+  */
+  static  auto  get_match(key_type key) noexcept {
+          return [key](const node_type& node) noexcept {
+              key_type l_name = node.value.get_name();
+              return (l_name.size() == key.size()) &&
+                  (std::memcmp(l_name.data(), key.data(), key.size()) == 0);
+          };
+  }
+
+  /* copy_p()
+     insert copies of all the entries of <copy>, with their keys taken from this map's resource
+  */
+  inline  void  copy_p(const string_map& copy) noexcept {
+          m_table.reserve(copy.size());
+          for(auto i_node = copy.m_table.begin(); i_node != copy.m_table.end(); i_node++) {
+              key_type l_name = i_node->value.get_name();
+              emplace_p(i_node->key, l_name, i_node->value.value);
+          }
+  }
+
+  /* emplace_p()
+     construct the entry for <key> with hash <hash> from <args>, unless there already is one; returns the entry for
+     <key> and whether it was just made, or nullptr if there was no memory for either the node or its key
+  */
+  template<typename... Args>
+  inline  std::pair<node_type*, bool> emplace_p(hash_type hash, key_type key, Args&&... args) noexcept {
+          auto l_result = m_table.emplace_match(hash, get_match(key), key, m_table.get_resource(), std::forward<Args>(args)...);
+          if(l_result.second) {
+              if(l_result.first->value.is_valid() == false) {
+                  m_table.erase(l_result.first);
+                  return {nullptr, false};
+              }
+          }
+          return l_result;
+  }
+
+  public:
+  inline  string_map(
+              std::pmr::memory_resource* r,
+              bool replace = false,
+              bool remove = true
+          ) noexcept:
+          m_table(r),
+          m_replace_bit(replace),
+          m_remove_bit(remove) {
+  }
+
+  inline  string_map(
+              std::pmr::memory_resource* r,
+              size_t reserve,
+              bool replace = false,
+              bool remove = true
+          ) noexcept:
+          m_table(r),
+          m_replace_bit(replace),
+          m_remove_bit(remove) {
+          m_table.reserve(reserve);
+  }
+
+  inline  string_map(const string_map& copy) noexcept:
+          m_table(copy.m_table.get_resource()),
+          m_replace_bit(copy.m_replace_bit),
+          m_remove_bit(copy.m_remove_bit) {
+          copy_p(copy);
+  }
+
+  inline  string_map(string_map&& copy) noexcept:
+          m_table(std::move(copy.m_table)),
+          m_replace_bit(copy.m_replace_bit),
+          m_remove_bit(copy.m_remove_bit) {
+  }
+
+          ~string_map() {
+  }
+
+  /* find()
+  */
+  inline  iterator_type find(key_type key) noexcept {
+          return   m_table.get_iterator(m_table.find_match(get_hash(key.data(), key.size()), get_match(key)));
+  }
+
+  /* find()
+  */
+  inline  iterator_type find(const char* key, std::size_t size) noexcept {
+          return   find(key_type(key, size));
+  }
+
+  /* find()
+  */
+  inline  iterator_type find(const char* key) noexcept {
+          return   find(key_type(key));
+  }
+
+  /* insert()
+   * construct the value for <key> from <args>; if the key is already there, replace its value if the map was made
+   * to, fail otherwise
+  */
+  template<typename... Args>
+  inline  iterator_type insert(key_type key, Args&&... args) noexcept {
+          hash_type l_hash   = get_hash(key.data(), key.size());
+          auto      l_result = emplace_p(l_hash, key, std::forward<Args>(args)...);
+          if(l_result.first != nullptr) {
+              if(l_result.second == false) {
+                  if(m_replace_bit == false) {
+                      return m_table.end();
+                  }
+                  l_result.first->value.value = value_type(std::forward<Args>(args)...);
+              }
+              return m_table.get_iterator(l_result.first);
+          }
+          return   m_table.end();
+  }
+
+  /* remove()
+   * erase node of given key, if found
+  */
+  inline  void remove(key_type key) noexcept {
+          if(m_table.erase_match(get_hash(key.data(), key.size()), get_match(key))) {
+              if(m_remove_bit) {
+                  m_table.collect();
+              }
+          }
+  }
+
+  /* remove()
+  */
+  inline  void remove(iterator_type pos) noexcept {
+          m_table.erase(pos.get());
+          if(m_remove_bit) {
+              m_table.collect();
+          }
+  }
+
+  /* compact()
+   * drop the tombstones and shrink the table to fit
+  */
+  inline  void compact() noexcept {
+          m_table.compact();
+  }
+
+  inline  size_t get_removed_count() const noexcept {
+          return m_table.get_removed_count();
+  }
+
+  inline  iterator_type begin() noexcept {
+          return m_table.begin();
+  }
+
+  inline  iterator_type none() noexcept {
+          return m_table.end();
+  }
+
+  inline  iterator_type end() noexcept {
+          return m_table.end();
+  }
+
+  inline  size_t size() const noexcept {
+          return m_table.size();
+  }
+
+  /* reserve()
+  */
+  inline  void reserve(size_t count) noexcept {
+          m_table.reserve(count);
+  }
+
+  /* clear()
+  */
+  inline  void clear(size_t = 0) noexcept {
+          m_table.clear();
+  }
+
+  inline  string_map& operator=(const string_map& rhs) noexcept {
+          if(std::addressof(rhs) != this) {
+              m_table.clear();
+              copy_p(rhs);
+          }
+          m_replace_bit = rhs.m_replace_bit;
+          m_remove_bit = rhs.m_remove_bit;
+          return *this;
+  }
+
+  inline  string_map& operator=(string_map&& rhs) noexcept {
+          if(std::addressof(rhs) != this) {
+              if(m_table.get_resource() == rhs.m_table.get_resource()) {
+                  m_table = std::move(rhs.m_table);
+              } else {
+                  m_table.clear();
+                  copy_p(rhs);
+              }
+          }
+          m_replace_bit = rhs.m_replace_bit;
+          m_remove_bit = rhs.m_remove_bit;
+          return *this;
+  }
+};
+/*namespace mmi*/ }
+#endif
@@ -26,6 +26,32 @@
 constexpr int pxi_policy_explicit = 0;
 constexpr int pxi_policy_fast     = 1;
 constexpr int pxi_policy_min      = 2;
+constexpr int pxi_policy_steal    = 3;
+constexpr int pxi_policy_weight   = 4;
+
+constexpr int pxi_idle_sleep      = 0;
+constexpr int pxi_idle_spin       = 1;
+
+/* enable queue statistics, see pxi/stats.h */
+#ifdef PXI_STATS
+constexpr bool pxi_stats_enable   = PXI_STATS;
+#else
+constexpr bool pxi_stats_enable   = false;
+#endif
+
+constexpr int pxi_affinity_none   = 0;
+constexpr int pxi_affinity_core   = 1;
+constexpr int pxi_affinity_node   = 2;
+
+/* results of cancel(): no such task; task removed or told it was cancelled; task not found, but it may still be on its
+   way to the worker and will be dropped if it turns up */
+constexpr int pxi_cancel_none     = 0;
+constexpr int pxi_cancel_done     = 1;
+constexpr int pxi_cancel_pending  = 2;
+
+constexpr int pxi_priority_batch       = -1;
+constexpr int pxi_priority_normal      = 0;
+constexpr int pxi_priority_interactive = 1;
 
 namespace pxi {
 
@@ -35,5 +61,16 @@ constexpr long int nsps  = nspms * 1000;    /*nanoseconds in a second*/
 constexpr long int msps  = 1000;            /*milliseconds in a second*/
 constexpr long int usps  = msps * 1000;
 
+/* cpu_relax()
+   tell the cpu we are spinning, so it can ease off and leave the core to a sibling thread
+*/
+inline  void  cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+#endif
+}
+
 /*namespace pxi*/ }
 #endif
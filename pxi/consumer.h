@@ -23,42 +23,91 @@
 **/
 #include <pxi.h>
 #include "producer.h"
+#include "ring.h"
+#include "future.h"
+#include "stats.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <pthread.h>
+#include <sched.h>
 #include <traits.h>
 #include <log.h>
 
 namespace pxi {
 
+template<typename Xt, typename Ct, int Size, int Policy>
+class pool;
+
 /* has_id_support
-   detect if custom callable type supports unique identifiers, in order to enable cancellation
+   detect if custom callable type supports unique identifiers through a const get_id(), in order to enable
+   cancellation
 */
 template<typename Xt>
 class has_id_support
 {
   template<typename Ot>
-  static  auto test(int) -> decltype(std::declval<Ot>().get_id(), std::false_type());
+  static  auto test(int) -> decltype(std::declval<const Ot&>().get_id());
 
-  template<typename Ot, typename Pt>
-  static  auto test(...) -> std::false_type;
+  template<typename Ot>
+  static  auto test(...) -> void;
 
   public:
-  static  constexpr bool value = std::is_same<decltype(test<Xt>(0)), std::size_t>::value;
+  static  constexpr bool value = std::is_convertible<decltype(test<Xt>(0)), std::size_t>::value;
 };
 
-/* has_weight_support
-   detect if custom callable type supports weight measurement, in order to enable more
-   accurate scheduling
+/* has_cancel_support
+   detect if custom callable type can be told it was cancelled while running, through set_cancelled(); the call comes
+   from the thread cancelling the task, concurrently with the task itself
 */
 template<typename Xt>
-class has_weight_support
+class has_cancel_support
 {
   template<typename Ot>
-  static  auto test(int) -> decltype(std::declval<Ot>().get_weight(), std::false_type());
+  static  auto test(int) -> decltype(std::declval<Ot&>().set_cancelled(), std::true_type());
 
-  template<typename Ot, typename Pt>
+  template<typename Ot>
   static  auto test(...) -> std::false_type;
 
   public:
-  static  constexpr bool value = std::is_same<decltype(test<Xt>(0)), float>::value;
+  static  constexpr bool value = decltype(test<Xt>(0))::value;
+};
+
+/* has_priority_support
+   detect if custom callable type carries a priority class (see pxi_priority_*) through a const get_priority(), in order to let latency sensitive
+   tasks jump ahead of batch work
+*/
+template<typename Xt>
+class has_priority_support
+{
+  template<typename Ot>
+  static  auto test(int) -> decltype(std::declval<const Ot&>().get_priority());
+
+  template<typename Ot>
+  static  auto test(...) -> void;
+
+  public:
+  static  constexpr bool value = std::is_convertible<decltype(test<Xt>(0)), int>::value;
+};
+
+/* has_deadline_support
+   detect if custom callable type carries a deadline, in order to run the tasks that have one earliest deadline first;
+   tasks without a deadline return time_point::max()
+*/
+template<typename Xt>
+class has_deadline_support
+{
+  template<typename Ot>
+  static  auto test(int) -> decltype(std::declval<const Ot&>().get_deadline());
+
+  template<typename Ot>
+  static  auto test(...) -> void;
+
+  public:
+  static  constexpr bool value = std::is_convertible<decltype(test<Xt>(0)), std::chrono::steady_clock::time_point>::value;
 };
 
 template<typename Xt, typename Ct>
@@ -88,24 +137,59 @@ class consumer: public producer<Xt, Ct>
           bool l_result = false;
           if(static_cast<int>(base_type::m_task_list.size()) < base_type::m_capacity_max) {
               base_type::m_list_guard.lock();
-              base_type::m_task_list.emplace_back(std::forward<Args>(args)...);
-              base_type::m_load += 1.0f;
+              base_type::add_load(base_type::get_weight(base_type::m_task_list.emplace_back(std::forward<Args>(args)...)));
               l_result = true;
               base_type::m_list_guard.unlock();
           }
           return l_result;
   }
 
+  /* schedule_bulk()
+     schedule the callables in the range [<first>, <last>) under a single lock; returns how many were taken
+  */
+  template<typename It>
+  inline  int      schedule_bulk(It first, It last) noexcept {
+          int l_size = static_cast<int>(std::distance(first, last));
+          base_type::m_list_guard.lock();
+          int l_room = base_type::m_capacity_max - static_cast<int>(base_type::m_task_list.size());
+          if(l_size > l_room) {
+              l_size = l_room;
+          }
+          if(l_size > 0) {
+              float l_load = 0.0f;
+              base_type::m_task_list.reserve(base_type::m_task_list.size() + l_size);
+              for(int i_task = 0; i_task < l_size; i_task++) {
+                  l_load += base_type::get_weight(base_type::m_task_list.emplace_back(*first));
+                  ++first;
+              }
+              base_type::add_load(l_load);
+          } else
+              l_size = 0;
+          base_type::m_list_guard.unlock();
+          return l_size;
+  }
+
+  /* schedule_async()
+     schedule <fn> and return the future of its result, see pxi::schedule_async()
+  */
+  template<typename Fn>
+  inline  auto     schedule_async(Fn&& fn) noexcept {
+          return   pxi::schedule_async(*this, std::forward<Fn>(fn));
+  }
+
   inline  iterator begin() noexcept {
           return   base_type::m_task_list.begin();
   }
 
   inline  void     process() noexcept {
+          float l_load      = 0.0f;
           auto  i_callable  = base_type::m_task_list.begin();
           while(i_callable != base_type::m_task_list.end()) {
+              l_load += base_type::get_weight(*i_callable);
               i_callable->operator()();
               i_callable++;
           }
+          base_type::add_load(-l_load);
           base_type::m_task_list.clear();
   }
 
@@ -118,8 +202,10 @@ class consumer: public producer<Xt, Ct>
           std::chrono::time_point<std::chrono::steady_clock> l_time_1 = time;
           std::chrono::duration<float>                       l_elapse;
           if(timeout >= 0.0f) {
+              float l_load      = 0.0f;
               auto  i_callable  = base_type::m_task_list.begin();
               while(i_callable != base_type::m_task_list.end()) {
+                  l_load += base_type::get_weight(*i_callable);
                   i_callable->operator()();
                   l_time_1 = std::chrono::steady_clock::now();
                   l_elapse = std::chrono::duration<float>(l_time_1 - l_time_0);
@@ -128,7 +214,9 @@ class consumer: public producer<Xt, Ct>
                   }
                   i_callable++;
               }
+              base_type::add_load(-l_load);
               if(i_callable < base_type::m_task_list.end()) {
+                  i_callable++;
                   base_type::m_task_list.erase(base_type::m_task_list.begin(), i_callable);
               } else
                   base_type::m_task_list.clear();
@@ -138,20 +226,53 @@ class consumer: public producer<Xt, Ct>
   inline  iterator end() noexcept {
           return   base_type::m_task_list.end();
   }
+
+  /* cancel()
+     remove the pending task with the given id; returns pxi_cancel_done, or pxi_cancel_none if there is no such task
+  */
+  inline  int      cancel(std::size_t id) noexcept {
+          if constexpr (has_id_support<Xt>::value) {
+              std::lock_guard<std::mutex> l_list_guard(base_type::m_list_guard);
+              for(auto i_callable = base_type::m_task_list.begin(); i_callable != base_type::m_task_list.end(); i_callable++) {
+                  if(i_callable->get_id() == id) {
+                      base_type::add_load(-base_type::get_weight(*i_callable));
+                      base_type::m_task_list.erase(i_callable);
+                      return pxi_cancel_done;
+                  }
+              }
+          }
+          return pxi_cancel_none;
+  }
  
   inline  int      count() const noexcept {
           return   static_cast<int>(base_type::m_task_list.size());
   }
 
+  /* get_stats()
+     tasks run on the calling threads, so only the depth is tracked
+  */
+  inline  bool     get_stats(stats_data& data) const noexcept {
+          data.reset();
+          data.depth = count();
+          return   false;
+  }
+
           consumer& operator=(const consumer&) noexcept = delete;
           consumer& operator=(consumer&&) noexcept = delete;
 };
 
+/* consumer<Xt, std::thread>
+   consumer running its tasks on a worker thread of its own;
+   producers hand tasks over through a lock-free ring, so scheduling never waits for a running task; when the ring is
+   full, tasks spill into the (locked) task list until the worker catches up. The mutex is otherwise only taken to start
+   the worker and to wake it up when it is idle.
+*/
 template<typename Xt>
 class consumer<Xt, std::thread>: public producer<Xt, std::thread>
 {
   private:
   using   base_type = producer<Xt, std::thread>;
+  using   list_type = typename base_type::list_type;
 
   public:
   using   consumer_type = typename base_type::consumer_type;
@@ -159,14 +280,438 @@ class consumer<Xt, std::thread>: public producer<Xt, std::thread>
   using   iterator      = typename base_type::iterator_type;
 
   private:
-  std::thread  m_thread;
-  int          m_live_index;
-  float        m_wait_time;
-  float        m_exit_time;
-  bool         m_wake;
-  bool         m_busy;
+  using   stamp_type = stamp<pxi_stats_enable>;
+  using   stats_type = stats<pxi_stats_enable>;
+
+  /* task_node
+     task waiting in the ring or in the deque, with the time it was scheduled when the statistics are compiled in
+  */
+  struct task_node: stamp_type {
+    callable_type callable;
+
+    template<typename... Args, typename = std::enable_if_t<std::is_constructible<callable_type, Args...>::value>>
+    inline  task_node(Args&&... args) noexcept:
+            stamp_type(),
+            callable(std::forward<Args>(args)...) {
+    }
+  };
+
+  using   ring_type = ring<task_node>;
+
+  private:
+  std::thread       m_thread;
+  ring_type         m_ring;
+  list_type         m_spill_list;   // tasks taken over from the task list, only touched by the worker
+  std::atomic<int>  m_task_count;
+  float             m_wait_time;
+  float             m_exit_time;
+  std::atomic<bool> m_spill;        // set while the task list holds tasks that didn't fit in the ring
+  std::atomic<bool> m_idle;         // set while the worker is about to wait or waiting for tasks
+  std::atomic<bool> m_wake;         // set while the worker thread runs
+  std::atomic<bool> m_halt;         // set to ask the worker to exit
+  std::atomic<int>  m_idle_mode;    // what the worker does when it runs out of tasks, see pxi_idle_*
+  int               m_spin_count;   // pxi_idle_spin: how long the worker watches the queue before parking
+  cpu_set_t         m_cpu_set;      // cpus the worker is allowed to run on, guarded by the list lock
+  bool              m_cpu_bind;     // set when the worker should be kept to m_cpu_set
+
+  std::deque<task_node> m_deque;      // work stealing: tasks waiting to run, shared with the peers
+  std::mutex        m_deque_guard;    // held only to move a task in or out of the deque, never while running one
+  std::atomic<int>  m_deque_count;
+  consumer* const*  m_peer_list;      // work stealing: all the consumers of the pool, this one included
+  int               m_peer_count;
+
+  /* rank_node
+     task that doesn't have the normal priority or has a deadline, waiting in the rank heap; ordered by priority, then
+     by deadline, then in the order they were scheduled
+  */
+  struct rank_node: stamp_type {
+    callable_type callable;
+    int           priority;
+    std::chrono::steady_clock::time_point deadline;
+    std::size_t   seq;
+  };
+
+  static constexpr bool has_rank_support = has_priority_support<Xt>::value || has_deadline_support<Xt>::value;
+
+  std::vector<rank_node> m_rank_list; // ranked tasks, as a heap
+  std::mutex        m_rank_guard;
+  std::atomic<int>  m_rank_count;
+  std::size_t       m_rank_seq;
+
+  /* cancel_node
+     cancellation of a task that may be on its way to the worker, either through the ring or already taken out of the
+     deque, rank heap or spill list; it only applies to the tasks pushed into the ring before <mark> and to the tasks
+     taken before <take>, and is kept until the worker has popped everything that was in the ring when the task was
+     cancelled
+  */
+  struct cancel_node {
+    std::size_t   id;
+    std::size_t   mark;
+    std::size_t   take;
+  };
+
+  static constexpr std::size_t take_none = std::numeric_limits<std::size_t>::max();
+
+  std::vector<cancel_node> m_cancel_list;
+  std::mutex        m_cancel_guard;
+  std::atomic<int>  m_cancel_count;
+  std::atomic<std::size_t> m_take_index; // running count of the tasks the worker took out of the deque, rank heap or spill list
+  std::size_t       m_take_ring;      // ring index of the task in hand, or take_none if it didn't come through the ring
+  std::size_t       m_take_mark;      // take index of the task in hand, or take_none if it came through the ring
+  std::mutex        m_run_guard;      // held by the worker only to publish m_run_ptr, never while running a task
+  callable_type*    m_run_ptr;        // task running on the worker
+
+  [[no_unique_address]] stats_type m_stats;
+
+  template<typename, typename, int, int>
+  friend class pool;
 
   private:
+  inline  void run(callable_type& callable) noexcept {
+          float l_weight = base_type::get_weight(callable);
+          m_stats.add_depth(m_task_count.load(std::memory_order_relaxed));
+          exec(callable);
+          m_task_count.fetch_sub(1, std::memory_order_relaxed);
+          base_type::add_load(-l_weight);
+  }
+
+  inline  void run(task_node& node) noexcept {
+          m_stats.add_wait(node);
+          run(node.callable);
+  }
+
+  /* exec()
+     run a task, unless it has been cancelled on its way
+  */
+  inline  void exec(callable_type& callable) noexcept {
+          std::int64_t l_start = m_stats.get_start();
+          if constexpr (has_id_support<Xt>::value) {
+              m_run_guard.lock();
+              m_run_ptr = std::addressof(callable);
+              m_run_guard.unlock();
+              if(is_cancelled(callable.get_id()) == false) {
+                  callable();
+              }
+              m_run_guard.lock();
+              m_run_ptr = nullptr;
+              m_run_guard.unlock();
+          } else
+              callable();
+          m_stats.add_run(l_start);
+  }
+
+  /* take_p()
+     count <count> tasks taken out of the deque, rank heap or spill list, for cancel(); returns the take index of the
+     first one
+  */
+  inline  std::size_t take_p(std::size_t count = 1) noexcept {
+          if constexpr (has_id_support<Xt>::value) {
+              return m_take_index.fetch_add(count, std::memory_order_seq_cst);
+          } else
+              return 0;
+  }
+
+  /* set_take()
+     remember where the task about to run came from, see is_cancelled()
+  */
+  inline  void set_take(std::size_t ring, std::size_t take) noexcept {
+          if constexpr (has_id_support<Xt>::value) {
+              m_take_ring = ring;
+              m_take_mark = take;
+          }
+  }
+
+  /* is_cancelled()
+     check for, and consume, a pending cancellation of the task with the given id; a cancellation only applies to the
+     task in hand if that was in the ring or in the worker's hands already when it was made, so that a task scheduled
+     later with the same id still runs
+  */
+  inline  bool is_cancelled(std::size_t id) noexcept {
+          if(m_cancel_count.load(std::memory_order_acquire) > 0) {
+              std::lock_guard<std::mutex> l_cancel_guard(m_cancel_guard);
+              for(auto i_cancel = m_cancel_list.begin(); i_cancel != m_cancel_list.end(); i_cancel++) {
+                  if((i_cancel->id == id) &&
+                      ((m_take_ring < i_cancel->mark) || (m_take_mark < i_cancel->take))) {
+                      m_cancel_list.erase(i_cancel);
+                      m_cancel_count.fetch_sub(1, std::memory_order_relaxed);
+                      return true;
+                  }
+              }
+          }
+          return false;
+  }
+
+  /* purge_cancel()
+     drop the cancellations of tasks that can no longer come out of the ring
+  */
+  inline  void purge_cancel() noexcept {
+          if(m_cancel_count.load(std::memory_order_acquire) > 0) {
+              std::size_t l_tail = m_ring.get_tail_index();
+              std::lock_guard<std::mutex> l_cancel_guard(m_cancel_guard);
+              auto i_cancel = std::remove_if(m_cancel_list.begin(), m_cancel_list.end(), [l_tail](const cancel_node& node) noexcept {
+                  return node.mark <= l_tail;
+              });
+              m_cancel_list.erase(i_cancel, m_cancel_list.end());
+              m_cancel_count.store(static_cast<int>(m_cancel_list.size()), std::memory_order_release);
+          }
+  }
+
+  static  int  get_priority(const callable_type& callable) noexcept {
+          if constexpr (has_priority_support<Xt>::value) {
+              return callable.get_priority();
+          } else
+              return pxi_priority_normal;
+  }
+
+  static  auto get_deadline(const callable_type& callable) noexcept -> std::chrono::steady_clock::time_point {
+          if constexpr (has_deadline_support<Xt>::value) {
+              return callable.get_deadline();
+          } else
+              return std::chrono::steady_clock::time_point::max();
+  }
+
+  static  bool is_rank_less(const rank_node& lhs, const rank_node& rhs) noexcept {
+          if(lhs.priority != rhs.priority) {
+              return lhs.priority < rhs.priority;
+          }
+          if(lhs.deadline != rhs.deadline) {
+              return lhs.deadline > rhs.deadline;
+          }
+          return lhs.seq > rhs.seq;
+  }
+
+  /* is_rank_ahead()
+     check if a ranked task should run before the plain tasks, which have the normal priority and no deadline
+  */
+  static  bool is_rank_ahead(const rank_node& node) noexcept {
+          if(node.priority == pxi_priority_normal) {
+              return node.deadline != std::chrono::steady_clock::time_point::max();
+          }
+          return node.priority > pxi_priority_normal;
+  }
+
+  /* run_rank()
+     run the ranked tasks that go ahead of the plain ones; with <behind>, run the top ranked task whatever its rank,
+     for when there is nothing else left to run
+  */
+  inline  bool run_rank(bool behind) noexcept {
+          bool l_result = false;
+          while(m_rank_count.load(std::memory_order_acquire) > 0) {
+              std::optional<callable_type> l_callable;
+              if(true) {
+                  std::lock_guard<std::mutex> l_rank_guard(m_rank_guard);
+                  if(m_rank_list.empty()) {
+                      break;
+                  }
+                  if(behind == false) {
+                      if(is_rank_ahead(m_rank_list.front()) == false) {
+                          break;
+                      }
+                  }
+                  std::pop_heap(m_rank_list.begin(), m_rank_list.end(), is_rank_less);
+                  m_stats.add_wait(m_rank_list.back());
+                  l_callable.emplace(std::move(m_rank_list.back().callable));
+                  m_rank_list.pop_back();
+                  set_take(take_none, take_p());
+                  m_rank_count.fetch_sub(1, std::memory_order_release);
+              }
+              run(*l_callable);
+              l_result = true;
+              if(behind) {
+                  break;
+              }
+              if(m_halt.load(std::memory_order_relaxed)) {
+                  break;
+              }
+          }
+          return l_result;
+  }
+
+  /* run_ahead()
+     run the ranked tasks that should go before the next plain task, if any
+  */
+  inline  bool run_ahead() noexcept {
+          if constexpr (has_rank_support) {
+              if(m_rank_count.load(std::memory_order_relaxed) > 0) {
+                  return run_rank(false);
+              }
+          }
+          return false;
+  }
+
+  /* take_front()
+     work stealing: take the oldest task of the deque, if any
+  */
+  inline  bool take_front(std::optional<task_node>& node) noexcept {
+          std::lock_guard<std::mutex> l_deque_guard(m_deque_guard);
+          if(m_deque.empty() == false) {
+              node.emplace(std::move(m_deque.front()));
+              m_deque.pop_front();
+              set_take(take_none, take_p());
+              m_deque_count.fetch_sub(1, std::memory_order_release);
+              return true;
+          }
+          return false;
+  }
+
+  /* take_back()
+     work stealing: take the newest task of the deque on behalf of <peer>
+  */
+  inline  bool take_back(std::optional<task_node>& node, consumer& peer) noexcept {
+          std::lock_guard<std::mutex> l_deque_guard(m_deque_guard);
+          if(m_deque.empty() == false) {
+              node.emplace(std::move(m_deque.back()));
+              m_deque.pop_back();
+              peer.set_take(take_none, peer.take_p());
+              m_deque_count.fetch_sub(1, std::memory_order_release);
+              m_task_count.fetch_sub(1, std::memory_order_relaxed);
+              base_type::add_load(-base_type::get_weight(node->callable));
+              return true;
+          }
+          return false;
+  }
+
+  /* steal_task()
+     work stealing: run one task from the back of the deque of the busiest peer
+  */
+  inline  bool steal_task() noexcept {
+          consumer* l_victim    = nullptr;
+          float     l_load_max  = 0.0f;
+          for(int i_peer = 0; i_peer < m_peer_count; i_peer++) {
+              consumer* l_peer = m_peer_list[i_peer];
+              if(l_peer != this) {
+                  if(l_peer->m_deque_count.load(std::memory_order_relaxed) > 0) {
+                      float l_load = l_peer->get_load();
+                      if(l_load > l_load_max) {
+                          l_victim   = l_peer;
+                          l_load_max = l_load;
+                      }
+                  }
+              }
+          }
+          if(l_victim != nullptr) {
+              std::optional<task_node> l_node;
+              if(l_victim->take_back(l_node, *this)) {
+                  m_stats.add_wait(*l_node);
+                  m_stats.add_steal();
+                  l_victim->m_stats.add_stolen();
+                  exec(l_node->callable);
+                  return true;
+              }
+          }
+          return false;
+  }
+
+  /* wake_peer()
+     work stealing: get an idle or stopped peer to come and help
+  */
+  inline  void wake_peer() noexcept {
+          for(int i_peer = 0; i_peer < m_peer_count; i_peer++) {
+              consumer* l_peer = m_peer_list[i_peer];
+              if(l_peer != this) {
+                  if((l_peer->m_wake.load() == false) ||
+                      (l_peer->m_idle.load() == true)) {
+                      l_peer->notify();
+                      break;
+                  }
+              }
+          }
+  }
+
+  /* run_tasks()
+     run the tasks in the ring, then the ones that spilled over, in the order they were scheduled;
+     returns false if there was nothing to run
+  */
+  inline  bool run_tasks() noexcept {
+          if constexpr (has_id_support<Xt>::value) {
+              purge_cancel();
+          }
+          bool l_result = run_ahead();
+          if(m_peer_count) {
+              std::optional<task_node> l_node;
+              while(take_front(l_node)) {
+                  run(*l_node);
+                  l_node.reset();
+                  l_result = true;
+                  if(m_halt.load(std::memory_order_relaxed)) {
+                      return l_result;
+                  }
+                  run_ahead();
+              }
+          } else {
+              while(m_ring.pop([this](task_node& node) noexcept { set_take(m_ring.get_tail_index(), take_none); run(node); })) {
+                  l_result = true;
+                  if(m_halt.load(std::memory_order_relaxed)) {
+                      return l_result;
+                  }
+                  run_ahead();
+              }
+              if(m_spill.load(std::memory_order_acquire)) {
+                  base_type::m_list_guard.lock();
+                  m_spill_list.swap(base_type::m_task_list);
+                  m_spill.store(false, std::memory_order_release);
+                  std::size_t l_take = take_p(m_spill_list.size());
+                  base_type::m_list_guard.unlock();
+                  for(auto& i_callable : m_spill_list) {
+                      set_take(take_none, l_take);
+                      run(i_callable);
+                      run_ahead();
+                  }
+                  m_spill_list.clear();
+                  l_result = true;
+              }
+          }
+          if constexpr (has_rank_support) {
+              if(l_result == false) {
+                  l_result = run_rank(true);
+              }
+          }
+          return l_result;
+  }
+
+  inline  bool has_tasks() const noexcept {
+          return (m_ring.is_empty() == false) ||
+              m_spill.load(std::memory_order_acquire) ||
+              (m_deque_count.load(std::memory_order_acquire) > 0) ||
+              (m_rank_count.load(std::memory_order_acquire) > 0);
+  }
+
+  /* spin()
+     pxi_idle_spin: watch the queue for a while before parking; the spin budget doubles each time it catches a task and
+     halves each time it runs out
+  */
+  inline  bool spin() noexcept {
+          for(int i_spin = 0; i_spin < m_spin_count; i_spin++) {
+              if(has_tasks() || m_halt.load(std::memory_order_relaxed)) {
+                  if(m_spin_count < spin_max) {
+                      m_spin_count <<= 1;
+                  }
+                  return true;
+              }
+              cpu_relax();
+          }
+          if(m_spin_count > spin_min) {
+              m_spin_count >>= 1;
+          }
+          return false;
+  }
+
+  /* leave()
+     tell the producers the worker is gone, unless a task got in meanwhile
+  */
+  inline  bool leave() noexcept {
+          std::lock_guard<std::mutex> l_list_guard(base_type::m_list_guard);
+          m_wake.store(false);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if(has_tasks()) {
+              if(m_halt.load() == false) {
+                  m_wake.store(true);
+                  return false;
+              }
+          }
+          return true;
+  }
+
           void loop() noexcept {
           std::chrono::time_point<std::chrono::steady_clock> l_time_0 = std::chrono::steady_clock::now();
           std::chrono::time_point<std::chrono::steady_clock> l_time_1;
@@ -175,89 +720,114 @@ class consumer<Xt, std::thread>: public producer<Xt, std::thread>
           std::chrono::duration<float>                       l_wait_time(m_wait_time);
           std::chrono::duration<float>                       l_exit_time(m_exit_time);
 
-          std::unique_lock<std::mutex>                       l_list_guard(base_type::m_list_guard);
-
-          m_wake       = true;
-          m_busy       = true;
-          m_live_index = 0;
-
-          printdbg("[queue:@%p] loop enter", this);
-          do {
-              if(m_live_index < static_cast<int>(base_type::m_task_list.size())) {
-                  // run through the list of tasks and execute them in the order they are stored
-                  do {
-                      if(m_wake) {
-                          base_type::m_task_list[m_live_index++]();
-                          base_type::m_load -= 1.0f;
-                      } else
-                          break;
+          printdbg("[queue:@%p] loop enter", __FILE__, __LINE__, this);
+          if(true) {
+              std::lock_guard<std::mutex> l_list_guard(base_type::m_list_guard);
+              if(m_cpu_bind) {
+                  pthread_setaffinity_np(pthread_self(), sizeof(m_cpu_set), std::addressof(m_cpu_set));
+              }
+          }
+          while(m_halt.load(std::memory_order_relaxed) == false) {
+              if(run_tasks()) {
+                  l_time_0 = std::chrono::steady_clock::now();
+                  continue;
+              }
+              if(steal_task()) {
+                  l_time_0 = std::chrono::steady_clock::now();
+                  continue;
+              }
+              // handle sleep and exit time
+              // if m_exit_time is 0.0f, exit the thread immediately;
+              // if m_exit_time is greater than 0.0f but not infinity, count the idle time and exit only if exceeded or equal;
+              // if m_exit_time is infinity don't count the time and exit only when asked to.
+              if(m_exit_time <= 0.0f) {
+                  if(leave()) {
+                      break;
                   }
-                  while(m_live_index < static_cast<int>(base_type::m_task_list.size()));
-
-                  // no longer busy
-                  m_busy = false;
-
-                  // discard tasks that were already executed in order to make room for potential new ones
-                  if(m_live_index == static_cast<int>(base_type::m_task_list.size())) {
-                      base_type::m_task_list.clear();
-                      m_live_index = 0;
-                  } else
-                  if(m_live_index >= base_type::m_capacity_min) {
-                      base_type::m_task_list.erase(
-                          base_type::m_task_list.begin(),
-                          base_type::m_task_list.begin() + m_live_index - 1
-                      );
-                      m_live_index = 0;
+                  continue;
+              }
+              // with pxi_idle_spin, spin before parking, then park until woken up: the thread stays around for the next
+              // burst instead of timing out
+              bool l_park = m_idle_mode.load(std::memory_order_relaxed) == pxi_idle_spin;
+              if(l_park) {
+                  if(spin()) {
+                      l_time_0 = std::chrono::steady_clock::now();
+                      continue;
                   }
               }
-              if(m_wake) {
-                  // handle sleep and exit time
-                  // if m_exit_time is 0.0f, exit the thread immediately;
-                  // if m_exit_time is greater than 0.0f but not infinity, count the idle time and exit only if exceeded or equal;
-                  // if m_exit_time is infinity don't count the time and exit only when m_wake is unset.
-                  if(m_exit_time > 0.0f) {
-                      if(base_type::m_list_fence.wait_for(l_list_guard, l_wait_time) == std::cv_status::no_timeout) {
-                          l_time_0 = std::chrono::steady_clock::now();
-                          l_time_1 = l_time_0;
-                          m_busy   = m_wake;
-                      } else
-                      if(m_exit_time != std::numeric_limits<float>::infinity()) {
-                          l_time_1    = std::chrono::steady_clock::now();
-                          l_idle_time = std::chrono::duration<float>(l_time_1 - l_time_0);
-                          if(l_idle_time < l_exit_time) {
-                              m_busy = m_wake;
-                          } else
-                              m_busy = false;
-                      } else
-                          m_busy = m_wake;
+              // announce the wait before the last look at the queue, so that a producer either sees the flag or has
+              // its task seen here
+              m_idle.store(true);
+              std::atomic_thread_fence(std::memory_order_seq_cst);
+              if(has_tasks()) {
+                  m_idle.store(false);
+                  continue;
+              }
+              m_stats.add_idle();
+              if(true) {
+                  std::unique_lock<std::mutex> l_list_guard(base_type::m_list_guard);
+                  auto l_wake = [this]() noexcept {
+                      return (m_idle.load() == false) || m_halt.load();
+                  };
+                  if(l_park) {
+                      base_type::m_list_fence.wait(l_list_guard, l_wake);
+                  } else
+                      base_type::m_list_fence.wait_for(l_list_guard, l_wait_time, l_wake);
+              }
+              if(m_idle.exchange(false)) {
+                  if((l_park == false) &&
+                      (m_exit_time != std::numeric_limits<float>::infinity())) {
+                      l_time_1    = std::chrono::steady_clock::now();
+                      l_idle_time = std::chrono::duration<float>(l_time_1 - l_time_0);
+                      if(l_idle_time >= l_exit_time) {
+                          if(leave()) {
+                              break;
+                          }
+                      }
                   }
+              } else {
+                  m_stats.add_wake();
+                  l_time_0 = std::chrono::steady_clock::now();
               }
           }
-          while(m_busy);
-          m_wake = false;
-          m_busy = false;
-          printdbg("[queue:@%p] loop leave", this);
+          printdbg("[queue:@%p] loop leave", __FILE__, __LINE__, this);
   }
 
   protected:
   inline  void resume_a() noexcept {
           join();
-          m_wake = true;
+          m_wake.store(true);
           m_thread = std::thread(&consumer::loop, this);
-          m_wake = m_thread.joinable();
+          m_wake.store(m_thread.joinable());
   }
 
   inline  void resume() noexcept {
-          if(base_type::m_list_guard.try_lock()) {
-              if(m_wake == false) {
-                  resume_a();
-              }
+          std::lock_guard<std::mutex> l_list_guard(base_type::m_list_guard);
+          if(m_wake.load() == false) {
+              resume_a();
+          }
+  }
+
+  /* notify()
+     make sure a worker is running and awake to pick up the task just scheduled
+  */
+  inline  void notify() noexcept {
+          if(m_wake.load() == false) {
+              resume();
+          } else
+          if(m_idle.load()) {
+              base_type::m_list_guard.lock();
+              m_idle.store(false);
               base_type::m_list_guard.unlock();
+              base_type::m_list_fence.notify_one();
           }
   }
-  
+
   inline  void suspend() noexcept {
-          m_wake = false;
+          base_type::m_list_guard.lock();
+          m_halt.store(true);
+          base_type::m_list_guard.unlock();
+          base_type::m_list_fence.notify_one();
   }
 
   inline  void join() noexcept {
@@ -269,24 +839,58 @@ class consumer<Xt, std::thread>: public producer<Xt, std::thread>
   public:
   static  constexpr float  default_wait_time = 0.1f;
   static  constexpr float  default_exit_time = 8.0f;
+  static  constexpr int    spin_min = 64;
+  static  constexpr int    spin_max = 16384;
 
   public:
   inline  consumer(int reserve) noexcept:
           base_type(reserve),
-          m_live_index(0),
+          m_ring(reserve),
+          m_task_count(0),
           m_wait_time(default_wait_time),
           m_exit_time(default_exit_time),
+          m_spill(false),
+          m_idle(false),
           m_wake(false),
-          m_busy(false) {
+          m_halt(false),
+          m_idle_mode(pxi_idle_sleep),
+          m_spin_count(spin_min),
+          m_cpu_bind(false),
+          m_deque_count(0),
+          m_peer_list(nullptr),
+          m_peer_count(0),
+          m_rank_count(0),
+          m_rank_seq(0),
+          m_cancel_count(0),
+          m_take_index(0),
+          m_take_ring(take_none),
+          m_take_mark(take_none),
+          m_run_ptr(nullptr) {
   }
 
   inline  consumer(int reserve, float wait_time, float exit_time, bool resume) noexcept:
           base_type(reserve),
-          m_live_index(0),
+          m_ring(reserve),
+          m_task_count(0),
           m_wait_time(wait_time),
           m_exit_time(exit_time),
+          m_spill(false),
+          m_idle(false),
           m_wake(false),
-          m_busy(false) {
+          m_halt(false),
+          m_idle_mode(pxi_idle_sleep),
+          m_spin_count(spin_min),
+          m_cpu_bind(false),
+          m_deque_count(0),
+          m_peer_list(nullptr),
+          m_peer_count(0),
+          m_rank_count(0),
+          m_rank_seq(0),
+          m_cancel_count(0),
+          m_take_index(0),
+          m_take_ring(take_none),
+          m_take_mark(take_none),
+          m_run_ptr(nullptr) {
           if(resume) {
               resume_a();
           }
@@ -300,25 +904,279 @@ class consumer<Xt, std::thread>: public producer<Xt, std::thread>
           join();
   }
 
+  protected:
+  /* schedule_r()
+     hand a ranked task to the rank heap
+  */
+  inline  bool schedule_r(callable_type&& callable, int priority, std::chrono::steady_clock::time_point deadline) noexcept {
+          if(m_task_count.load(std::memory_order_relaxed) < base_type::m_capacity_max) {
+              m_task_count.fetch_add(1, std::memory_order_relaxed);
+              base_type::add_load(base_type::get_weight(callable));
+              m_rank_guard.lock();
+              m_rank_list.push_back(rank_node{{}, std::move(callable), priority, deadline, m_rank_seq++});
+              std::push_heap(m_rank_list.begin(), m_rank_list.end(), is_rank_less);
+              m_rank_guard.unlock();
+              m_rank_count.fetch_add(1, std::memory_order_release);
+              std::atomic_thread_fence(std::memory_order_seq_cst);
+              notify();
+              return true;
+          }
+          return false;
+  }
+
   template<typename... Args>
-  inline  bool schedule(Args&&... args) noexcept {
-          bool l_result = false;
-          if(static_cast<int>(base_type::m_task_list.size()) < base_type::m_capacity_max) {
-              base_type::m_list_guard.lock();
-              base_type::m_task_list.emplace_back(std::forward<Args>(args)...);
-              if(m_wake == true) {
-                  if(m_busy == false) {
-                      base_type::m_list_fence.notify_one();
+  inline  bool schedule_a(float weight, Args&&... args) noexcept {
+          if(m_task_count.load(std::memory_order_relaxed) < base_type::m_capacity_max) {
+              m_task_count.fetch_add(1, std::memory_order_relaxed);
+              base_type::add_load(weight);
+              // once tasks have spilled over, keep adding to the task list until the worker takes it over, so that
+              // tasks run in the order they were scheduled
+              bool l_push = false;
+              if(m_peer_count) {
+                  // work stealing: queue up in the deque, where idle peers can get at the task
+                  m_deque_guard.lock();
+                  m_deque.emplace_back(std::forward<Args>(args)...);
+                  m_deque_guard.unlock();
+                  if(m_deque_count.fetch_add(1, std::memory_order_acq_rel) > 0) {
+                      wake_peer();
                   }
+                  l_push = true;
               } else
-              if(m_wake == false) {
-                  resume_a();
+              if(m_spill.load(std::memory_order_acquire) == false) {
+                  l_push = m_ring.push(std::forward<Args>(args)...);
               }
-              l_result = true;
-              base_type::m_load += 1.0f;
-              base_type::m_list_guard.unlock();
+              if(l_push == false) {
+                  base_type::m_list_guard.lock();
+                  base_type::m_task_list.emplace_back(std::forward<Args>(args)...);
+                  m_spill.store(true, std::memory_order_release);
+                  base_type::m_list_guard.unlock();
+              }
+              std::atomic_thread_fence(std::memory_order_seq_cst);
+              notify();
+              return true;
           }
-          return l_result;
+          return false;
+  }
+
+  public:
+  /* schedule()
+     schedule a task; when the callable type supports priorities or deadlines, the tasks that don't have the normal
+     priority or have a deadline go through the rank heap, the others through the ring
+  */
+  template<typename... Args>
+  inline  bool     schedule(Args&&... args) noexcept {
+          if constexpr (has_rank_support) {
+              callable_type l_callable(std::forward<Args>(args)...);
+              int  l_priority = get_priority(l_callable);
+              auto l_deadline = get_deadline(l_callable);
+              if((l_priority != pxi_priority_normal) ||
+                  (l_deadline != std::chrono::steady_clock::time_point::max())) {
+                  return schedule_r(std::move(l_callable), l_priority, l_deadline);
+              }
+              return schedule_a(base_type::get_weight(l_callable), std::move(l_callable));
+          } else
+          if constexpr (has_weight_support<Xt>::value) {
+              callable_type l_callable(std::forward<Args>(args)...);
+              return schedule_a(base_type::get_weight(l_callable), std::move(l_callable));
+          } else
+              return schedule_a(1.0f, std::forward<Args>(args)...);
+  }
+
+  /* schedule_bulk()
+     schedule the callables in the range [<first>, <last>) with a single lock or CAS and a single wake up; returns
+     how many were taken; ranges holding ranked tasks are scheduled one task at a time
+  */
+  template<typename It>
+  inline  int      schedule_bulk(It first, It last) noexcept {
+          if constexpr (has_rank_support) {
+              for(It i_task = first; i_task != last; ++i_task) {
+                  const callable_type& l_callable = *i_task;
+                  if((get_priority(l_callable) != pxi_priority_normal) ||
+                      (get_deadline(l_callable) != std::chrono::steady_clock::time_point::max())) {
+                      int l_done = 0;
+                      while((first != last) && schedule(*first)) {
+                          ++first;
+                          ++l_done;
+                      }
+                      return l_done;
+                  }
+              }
+          }
+          int l_size = static_cast<int>(std::distance(first, last));
+          int l_room = base_type::m_capacity_max - m_task_count.load(std::memory_order_relaxed);
+          if(l_size > l_room) {
+              l_size = l_room;
+          }
+          if(l_size > 0) {
+              float l_load = static_cast<float>(l_size);
+              if constexpr (has_weight_support<Xt>::value) {
+                  It  i_task = first;
+                  l_load = 0.0f;
+                  for(int i_count = 0; i_count < l_size; i_count++) {
+                      l_load += base_type::get_weight(*i_task);
+                      ++i_task;
+                  }
+              }
+              m_task_count.fetch_add(l_size, std::memory_order_relaxed);
+              base_type::add_load(l_load);
+              if(m_peer_count) {
+                  m_deque_guard.lock();
+                  for(int i_task = 0; i_task < l_size; i_task++) {
+                      m_deque.emplace_back(*first);
+                      ++first;
+                  }
+                  m_deque_guard.unlock();
+                  if(m_deque_count.fetch_add(l_size, std::memory_order_acq_rel) + l_size > 1) {
+                      wake_peer();
+                  }
+              } else {
+                  int l_push = 0;
+                  if(m_spill.load(std::memory_order_acquire) == false) {
+                      l_push = static_cast<int>(m_ring.push_bulk(first, l_size));
+                  }
+                  if(l_push < l_size) {
+                      base_type::m_list_guard.lock();
+                      for(int i_task = l_push; i_task < l_size; i_task++) {
+                          base_type::m_task_list.emplace_back(*first);
+                          ++first;
+                      }
+                      m_spill.store(true, std::memory_order_release);
+                      base_type::m_list_guard.unlock();
+                  }
+              }
+              std::atomic_thread_fence(std::memory_order_seq_cst);
+              notify();
+              return l_size;
+          }
+          return 0;
+  }
+
+  /* schedule_async()
+     schedule <fn> and return the future of its result, see pxi::schedule_async()
+  */
+  template<typename Fn>
+  inline  auto     schedule_async(Fn&& fn) noexcept {
+          return   pxi::schedule_async(*this, std::forward<Fn>(fn));
+  }
+
+  /* cancel()
+     cancel the task with the given id: a pending task is removed without running, a running one is told through
+     set_cancelled(), if the callable type has it, and either way pxi_cancel_done is returned. The ring can't be
+     searched, so if the task is not found while the ring holds tasks or the worker is busy, it may still be on its way:
+     it is then dropped if the worker gets to it, provided it was scheduled before the call, and pxi_cancel_pending is
+     returned. Returns pxi_cancel_none otherwise.
+  */
+  inline  int      cancel(std::size_t id) noexcept {
+          if constexpr (has_id_support<Xt>::value) {
+              std::lock_guard<std::mutex> l_run_guard(m_run_guard);
+              if(m_run_ptr != nullptr) {
+                  if(m_run_ptr->get_id() == id) {
+                      if constexpr (has_cancel_support<Xt>::value) {
+                          m_run_ptr->set_cancelled();
+                      }
+                      return pxi_cancel_done;
+                  }
+              }
+              if(m_deque_count.load(std::memory_order_acquire) > 0) {
+                  std::lock_guard<std::mutex> l_deque_guard(m_deque_guard);
+                  for(auto i_node = m_deque.begin(); i_node != m_deque.end(); i_node++) {
+                      if(i_node->callable.get_id() == id) {
+                          base_type::add_load(-base_type::get_weight(i_node->callable));
+                          m_deque.erase(i_node);
+                          m_deque_count.fetch_sub(1, std::memory_order_relaxed);
+                          m_task_count.fetch_sub(1, std::memory_order_relaxed);
+                          return pxi_cancel_done;
+                      }
+                  }
+              }
+              if(m_rank_count.load(std::memory_order_acquire) > 0) {
+                  std::lock_guard<std::mutex> l_rank_guard(m_rank_guard);
+                  for(auto i_node = m_rank_list.begin(); i_node != m_rank_list.end(); i_node++) {
+                      if(i_node->callable.get_id() == id) {
+                          base_type::add_load(-base_type::get_weight(i_node->callable));
+                          m_rank_list.erase(i_node);
+                          std::make_heap(m_rank_list.begin(), m_rank_list.end(), is_rank_less);
+                          m_rank_count.fetch_sub(1, std::memory_order_relaxed);
+                          m_task_count.fetch_sub(1, std::memory_order_relaxed);
+                          return pxi_cancel_done;
+                      }
+                  }
+              }
+              std::lock_guard<std::mutex> l_list_guard(base_type::m_list_guard);
+              for(auto i_callable = base_type::m_task_list.begin(); i_callable != base_type::m_task_list.end(); i_callable++) {
+                  if(i_callable->get_id() == id) {
+                      base_type::add_load(-base_type::get_weight(*i_callable));
+                      base_type::m_task_list.erase(i_callable);
+                      m_task_count.fetch_sub(1, std::memory_order_relaxed);
+                      return pxi_cancel_done;
+                  }
+              }
+              // the task may sit in the ring, or be in the hands of the worker about to run it
+              if((m_ring.get_count() > 0) ||
+                  (m_wake.load() && (m_idle.load() == false))) {
+                  std::lock_guard<std::mutex> l_cancel_guard(m_cancel_guard);
+                  m_cancel_list.push_back(cancel_node{id, m_ring.get_head_index(), m_take_index.load(std::memory_order_seq_cst)});
+                  m_cancel_count.fetch_add(1, std::memory_order_release);
+                  return pxi_cancel_pending;
+              }
+          }
+          return pxi_cancel_none;
+  }
+
+  inline  int      count() const noexcept {
+          return   m_task_count.load(std::memory_order_relaxed);
+  }
+
+  /* get_stats()
+     take a snapshot of the statistics of the queue; returns false, with only the depth filled in, unless they are
+     compiled in with PXI_STATS
+  */
+  inline  bool     get_stats(stats_data& data) const noexcept {
+          data.reset();
+          data.depth = count();
+          return   m_stats.get(data);
+  }
+
+  /* set_idle_mode()
+     choose what the worker does when it runs out of tasks: pxi_idle_sleep waits in steps of the wait time and lets the
+     thread go after the exit time; pxi_idle_spin spins adaptively, then parks the thread until there is work again
+  */
+  inline  void     set_idle_mode(int mode) noexcept {
+          m_idle_mode.store(mode, std::memory_order_relaxed);
+  }
+
+  inline  int      get_idle_mode() const noexcept {
+          return   m_idle_mode.load(std::memory_order_relaxed);
+  }
+
+  /* set_affinity()
+     keep the worker thread on the cpus in <set>, or let it run anywhere if <set> is nullptr; takes effect right away
+     if the worker is running, otherwise when it starts
+  */
+  inline  bool     set_affinity(const cpu_set_t* set) noexcept {
+          std::lock_guard<std::mutex> l_list_guard(base_type::m_list_guard);
+          if(set != nullptr) {
+              m_cpu_set  = *set;
+              m_cpu_bind = true;
+          } else {
+              // all the cpus the process may run on
+              if(sched_getaffinity(0, sizeof(m_cpu_set), std::addressof(m_cpu_set)) != 0) {
+                  return false;
+              }
+              m_cpu_bind = false;
+          }
+          if(m_wake.load() && m_thread.joinable()) {
+              return pthread_setaffinity_np(m_thread.native_handle(), sizeof(m_cpu_set), std::addressof(m_cpu_set)) == 0;
+          }
+          return true;
+  }
+
+  /* set_peers()
+     switch to work stealing, with the given list of consumers as peers; must be called before any task is scheduled
+  */
+  inline  void     set_peers(consumer* const* list, int count) noexcept {
+          m_peer_list  = list;
+          m_peer_count = count;
   }
 
           consumer& operator=(const consumer&) noexcept = delete;
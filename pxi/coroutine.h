@@ -0,0 +1,580 @@
+#ifndef pxi_coroutine_h
+#define pxi_coroutine_h
+/** 
+    Copyright (c) 2021, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include <pxi.h>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include "future.h"
+#include <mmi.h>
+#include <mmi/slab.h>
+#include <sys/ios/fio.h>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <optional>
+#include <thread>
+#include <cerrno>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace pxi {
+
+/* frame_allocator
+   recycling allocator for coroutine frames: frames are rounded up to a power of two between 64 bytes and 4KB and
+   carved from one slab per size class, so that a frame released on one worker is handed out again to the next
+   coroutine without a trip to the heap; larger frames go to the heap
+*/
+class frame_allocator
+{
+  public:
+  static constexpr std::size_t size_min = 64u;
+  static constexpr std::size_t size_max = 4096u;
+
+  private:
+  template<std::size_t Size>
+  struct block {
+    alignas(std::max_align_t) unsigned char data[Size];
+  };
+
+  template<std::size_t Size>
+  using  slab_type = mmi::slab<block<Size>, (Size < 1024u ? 256u : 32u)>;
+
+  template<std::size_t Size>
+  static  slab_type<Size>& get_slab() noexcept {
+          static slab_type<Size> s_slab;
+          return s_slab;
+  }
+
+  template<std::size_t Size>
+  static  void* allocate_a(std::size_t size) noexcept {
+          if constexpr (Size <= size_max) {
+              if(size <= Size) {
+                  return get_slab<Size>().emplace();
+              }
+              return allocate_a<Size * 2u>(size);
+          } else
+              return ::operator new(size, std::nothrow);
+  }
+
+  template<std::size_t Size>
+  static  void  deallocate_a(void* p, std::size_t size) noexcept {
+          if constexpr (Size <= size_max) {
+              if(size <= Size) {
+                  get_slab<Size>().remove(static_cast<block<Size>*>(p));
+              } else
+                  deallocate_a<Size * 2u>(p, size);
+          } else
+              ::operator delete(p);
+  }
+
+  public:
+  static  void* allocate(std::size_t size) noexcept {
+          return allocate_a<size_min>(size);
+  }
+
+  static  void  deallocate(void* p, std::size_t size) noexcept {
+          deallocate_a<size_min>(p, size);
+  }
+};
+
+template<typename Rt = void>
+class co_task;
+
+/* co_promise_base
+   what the promises of all co_task types share: frame allocation, lazy start, and handing control back to the
+   awaiting coroutine when done; a detached coroutine frees its own frame at the end
+*/
+class co_promise_base
+{
+  std::coroutine_handle<> m_continuation;
+  bool                    m_detached;
+
+  public:
+  class final_awaiter
+  {
+    public:
+    inline  bool  await_ready() const noexcept {
+            return false;
+    }
+
+    template<typename Pt>
+    inline  std::coroutine_handle<> await_suspend(std::coroutine_handle<Pt> handle) noexcept {
+            co_promise_base& l_promise = handle.promise();
+            if(l_promise.m_continuation) {
+                return l_promise.m_continuation;
+            }
+            if(l_promise.m_detached) {
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+    }
+
+    inline  void  await_resume() const noexcept {
+    }
+  };
+
+  public:
+  inline  co_promise_base() noexcept:
+          m_continuation(),
+          m_detached(false) {
+  }
+
+  static  void* operator new(std::size_t size) noexcept {
+          return frame_allocator::allocate(size);
+  }
+
+  static  void  operator delete(void* p, std::size_t size) noexcept {
+          frame_allocator::deallocate(p, size);
+  }
+
+  inline  std::suspend_always initial_suspend() const noexcept {
+          return {};
+  }
+
+  inline  final_awaiter final_suspend() const noexcept {
+          return {};
+  }
+
+  inline  void  unhandled_exception() noexcept {
+          std::terminate();
+  }
+
+  inline  void  set_continuation(std::coroutine_handle<> handle) noexcept {
+          m_continuation = handle;
+  }
+
+  inline  void  set_detached() noexcept {
+          m_detached = true;
+  }
+};
+
+template<typename Rt>
+class co_promise: public co_promise_base
+{
+  std::optional<Rt> m_value;
+
+  public:
+  inline  co_task<Rt> get_return_object() noexcept;
+
+  static  co_task<Rt> get_return_object_on_allocation_failure() noexcept {
+          return co_task<Rt>();
+  }
+
+  template<typename Vt>
+  inline  void  return_value(Vt&& value) noexcept {
+          m_value.emplace(std::forward<Vt>(value));
+  }
+
+  inline  Rt    get_value() noexcept {
+          return std::move(*m_value);
+  }
+};
+
+template<>
+class co_promise<void>: public co_promise_base
+{
+  public:
+  inline  co_task<void> get_return_object() noexcept;
+
+  static  co_task<void> get_return_object_on_allocation_failure() noexcept;
+
+  inline  void  return_void() noexcept {
+  }
+
+  inline  void  get_value() noexcept {
+  }
+};
+
+/* co_task
+   coroutine that starts when it is first awaited, or when start() detaches it; awaiting it from another coroutine
+   resumes the awaiting one as soon as it completes, on the same thread
+*/
+template<typename Rt>
+class co_task
+{
+  public:
+  using  promise_type = co_promise<Rt>;
+  using  handle_type  = std::coroutine_handle<promise_type>;
+
+  private:
+  handle_type   m_handle;
+
+  public:
+  class awaiter
+  {
+    handle_type   m_handle;
+
+    public:
+    inline  awaiter(handle_type handle) noexcept:
+            m_handle(handle) {
+    }
+
+    inline  bool  await_ready() const noexcept {
+            return (m_handle == nullptr) || m_handle.done();
+    }
+
+    inline  std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) noexcept {
+            m_handle.promise().set_continuation(handle);
+            return m_handle;
+    }
+
+    inline  Rt    await_resume() noexcept {
+            return m_handle.promise().get_value();
+    }
+  };
+
+  public:
+  inline  co_task() noexcept:
+          m_handle(nullptr) {
+  }
+
+  inline  co_task(handle_type handle) noexcept:
+          m_handle(handle) {
+  }
+
+          co_task(const co_task&) noexcept = delete;
+
+  inline  co_task(co_task&& copy) noexcept:
+          m_handle(copy.m_handle) {
+          copy.m_handle = nullptr;
+  }
+
+  inline  ~co_task() {
+          if(m_handle) {
+              m_handle.destroy();
+          }
+  }
+
+  /* start()
+     detach the coroutine and run it up to its first suspension point; it frees itself when done
+  */
+  inline  void  start() noexcept {
+          if(m_handle) {
+              handle_type l_handle = m_handle;
+              m_handle = nullptr;
+              l_handle.promise().set_detached();
+              l_handle.resume();
+          }
+  }
+
+  inline  bool  is_valid() const noexcept {
+          return m_handle != nullptr;
+  }
+
+  inline  bool  is_done() const noexcept {
+          return m_handle && m_handle.done();
+  }
+
+  inline  awaiter operator co_await() noexcept {
+          return awaiter(m_handle);
+  }
+
+          co_task& operator=(const co_task&) noexcept = delete;
+
+  inline  co_task& operator=(co_task&& rhs) noexcept {
+          std::swap(m_handle, rhs.m_handle);
+          return *this;
+  }
+};
+
+template<typename Rt>
+inline  co_task<Rt> co_promise<Rt>::get_return_object() noexcept {
+        return co_task<Rt>(co_task<Rt>::handle_type::from_promise(*this));
+}
+
+inline  co_task<void> co_promise<void>::get_return_object() noexcept {
+        return co_task<void>(co_task<void>::handle_type::from_promise(*this));
+}
+
+inline  co_task<void> co_promise<void>::get_return_object_on_allocation_failure() noexcept {
+        return co_task<void>();
+}
+
+template<typename Rt>
+co_task<void> spawn_a(co_task<Rt> task, promise<Rt> result) noexcept {
+        if constexpr (std::is_void<Rt>::value) {
+            co_await task;
+            result.set_value();
+        } else
+            result.set_value(co_await task);
+}
+
+/* spawn()
+   start <task> detached and return the future of its result, for code that is not a coroutine itself
+*/
+template<typename Rt>
+inline  future<Rt> spawn(co_task<Rt>&& task) noexcept {
+        promise<Rt> l_promise;
+        future<Rt>  l_future = l_promise.get_future();
+        if(l_future.is_valid() && task.is_valid()) {
+            co_task<void> l_task = spawn_a(std::move(task), std::move(l_promise));
+            if(l_task.is_valid()) {
+                l_task.start();
+                return l_future;
+            }
+        }
+        return future<Rt>();
+}
+
+/* schedule_awaiter
+   suspend the coroutine and resume it on a worker of <queue> (a queue, or a pool); if the queue won't take it, the
+   coroutine carries on where it is. The callable type of the queue must be constructible from a lambda, as
+   std::function is.
+*/
+template<typename Qt>
+class schedule_awaiter
+{
+  Qt&   m_queue;
+
+  public:
+  inline  schedule_awaiter(Qt& queue) noexcept:
+          m_queue(queue) {
+  }
+
+  inline  bool  await_ready() const noexcept {
+          return false;
+  }
+
+  inline  bool  await_suspend(std::coroutine_handle<> handle) noexcept {
+          return m_queue.schedule([handle]() noexcept { handle.resume(); });
+  }
+
+  inline  void  await_resume() const noexcept {
+  }
+};
+
+template<typename Qt>
+inline  schedule_awaiter<Qt> schedule_on(Qt& queue) noexcept {
+        return schedule_awaiter<Qt>(queue);
+}
+
+/* reactor
+   epoll based readiness notifier running on a thread of its own; coroutines wait for a descriptor to become readable
+   or writable and are resumed from the reactor thread, or handed over to a queue when one is given. Each wait arms
+   the descriptor once (EPOLLONESHOT), so only one coroutine may wait on a given descriptor at a time.
+*/
+class reactor
+{
+  public:
+  /* waiter
+     coroutine waiting on a descriptor; lives in the frame of the waiting coroutine
+  */
+  struct waiter {
+    std::coroutine_handle<> handle;
+    void        (*resume)(void*, std::coroutine_handle<>);
+    void*       queue;
+    unsigned int events;
+  };
+
+  static constexpr int event_count = 64;
+
+  private:
+  int               m_poll;
+  int               m_wake;
+  std::atomic<bool> m_halt;
+  std::thread       m_thread;
+
+  private:
+          void  loop() noexcept {
+          epoll_event l_event_list[event_count];
+          while(m_halt.load(std::memory_order_relaxed) == false) {
+              int l_event_count = epoll_wait(m_poll, l_event_list, event_count, -1);
+              if(l_event_count < 0) {
+                  if(errno == EINTR) {
+                      continue;
+                  }
+                  break;
+              }
+              for(int i_event = 0; i_event < l_event_count; i_event++) {
+                  waiter* l_waiter = static_cast<waiter*>(l_event_list[i_event].data.ptr);
+                  if(l_waiter != nullptr) {
+                      l_waiter->events = l_event_list[i_event].events;
+                      if(l_waiter->resume != nullptr) {
+                          l_waiter->resume(l_waiter->queue, l_waiter->handle);
+                      } else
+                          l_waiter->handle.resume();
+                  } else {
+                      std::uint64_t l_count;
+                      while(::read(m_wake, std::addressof(l_count), sizeof(l_count)) > 0) {
+                      }
+                  }
+              }
+          }
+  }
+
+  public:
+  inline  reactor() noexcept:
+          m_poll(epoll_create1(EPOLL_CLOEXEC)),
+          m_wake(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+          m_halt(false) {
+          if((m_poll >= 0) &&
+              (m_wake >= 0)) {
+              epoll_event l_event;
+              l_event.events   = EPOLLIN;
+              l_event.data.ptr = nullptr;
+              if(epoll_ctl(m_poll, EPOLL_CTL_ADD, m_wake, std::addressof(l_event)) == 0) {
+                  m_thread = std::thread(&reactor::loop, this);
+              }
+          }
+  }
+
+          reactor(const reactor&) noexcept = delete;
+          reactor(reactor&&) noexcept = delete;
+
+  inline  ~reactor() {
+          if(m_thread.joinable()) {
+              std::uint64_t l_count = 1;
+              m_halt.store(true);
+              if(::write(m_wake, std::addressof(l_count), sizeof(l_count)) > 0) {
+                  m_thread.join();
+              } else
+                  m_thread.detach();
+          }
+          if(m_wake >= 0) {
+              ::close(m_wake);
+          }
+          if(m_poll >= 0) {
+              ::close(m_poll);
+          }
+  }
+
+  /* watch()
+     arm <desc> for a single notification of <events>; returns -1 on error, 0 when the descriptor was armed, and 1 when
+     it can't be polled (regular files) and should be taken as ready
+  */
+  inline  int   watch(int desc, unsigned int events, waiter* waiter) noexcept {
+          epoll_event l_event;
+          l_event.events   = events | EPOLLONESHOT;
+          l_event.data.ptr = waiter;
+          if(epoll_ctl(m_poll, EPOLL_CTL_MOD, desc, std::addressof(l_event)) == 0) {
+              return 0;
+          }
+          if(errno == ENOENT) {
+              if(epoll_ctl(m_poll, EPOLL_CTL_ADD, desc, std::addressof(l_event)) == 0) {
+                  return 0;
+              }
+          }
+          if(errno == EPERM) {
+              return 1;
+          }
+          return -1;
+  }
+
+  /* forget()
+     drop <desc> from the reactor; must be called before closing a descriptor that has been waited on
+  */
+  inline  void  forget(int desc) noexcept {
+          epoll_ctl(m_poll, EPOLL_CTL_DEL, desc, nullptr);
+  }
+
+  inline  bool  is_valid() const noexcept {
+          return m_thread.joinable();
+  }
+
+          reactor& operator=(const reactor&) noexcept = delete;
+          reactor& operator=(reactor&&) noexcept = delete;
+};
+
+/* io_awaiter
+   suspend the coroutine until a descriptor is ready; resumes with the epoll event mask (EPOLLERR when the descriptor
+   could not be watched)
+*/
+template<typename Qt>
+class io_awaiter
+{
+  reactor&          m_reactor;
+  int               m_desc;
+  unsigned int      m_events;
+  Qt*               m_queue;
+  reactor::waiter   m_waiter;
+
+  static  void  resume_on(void* queue, std::coroutine_handle<> handle) noexcept {
+          if(static_cast<Qt*>(queue)->schedule([handle]() noexcept { handle.resume(); }) == false) {
+              handle.resume();
+          }
+  }
+
+  public:
+  inline  io_awaiter(reactor& reactor, int desc, unsigned int events, Qt* queue) noexcept:
+          m_reactor(reactor),
+          m_desc(desc),
+          m_events(events),
+          m_queue(queue),
+          m_waiter{} {
+  }
+
+  inline  bool  await_ready() const noexcept {
+          return false;
+  }
+
+  inline  bool  await_suspend(std::coroutine_handle<> handle) noexcept {
+          m_waiter.handle = handle;
+          m_waiter.events = 0;
+          if constexpr (std::is_void<Qt>::value == false) {
+              m_waiter.resume = resume_on;
+              m_waiter.queue  = m_queue;
+          }
+          int l_watch = m_reactor.watch(m_desc, m_events, std::addressof(m_waiter));
+          if(l_watch == 0) {
+              return true;
+          }
+          m_waiter.events = l_watch > 0 ? m_events : EPOLLERR;
+          return false;
+  }
+
+  inline  unsigned int await_resume() const noexcept {
+          return m_waiter.events;
+  }
+};
+
+inline  io_awaiter<void> wait_readable(reactor& reactor, int desc) noexcept {
+        return io_awaiter<void>(reactor, desc, EPOLLIN | EPOLLRDHUP, nullptr);
+}
+
+inline  io_awaiter<void> wait_readable(reactor& reactor, const fio& io) noexcept {
+        return wait_readable(reactor, io.get_descriptor());
+}
+
+template<typename Qt>
+inline  io_awaiter<Qt> wait_readable(reactor& reactor, const fio& io, Qt& queue) noexcept {
+        return io_awaiter<Qt>(reactor, io.get_descriptor(), EPOLLIN | EPOLLRDHUP, std::addressof(queue));
+}
+
+inline  io_awaiter<void> wait_writable(reactor& reactor, int desc) noexcept {
+        return io_awaiter<void>(reactor, desc, EPOLLOUT, nullptr);
+}
+
+inline  io_awaiter<void> wait_writable(reactor& reactor, const fio& io) noexcept {
+        return wait_writable(reactor, io.get_descriptor());
+}
+
+template<typename Qt>
+inline  io_awaiter<Qt> wait_writable(reactor& reactor, const fio& io, Qt& queue) noexcept {
+        return io_awaiter<Qt>(reactor, io.get_descriptor(), EPOLLOUT, std::addressof(queue));
+}
+
+/*namespace pxi*/ }
+#endif
+#endif
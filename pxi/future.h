@@ -0,0 +1,510 @@
+#ifndef pxi_future_h
+#define pxi_future_h
+/** 
+    Copyright (c) 2021, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include <pxi.h>
+#include <mmi.h>
+#include <mmi/slab.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace pxi {
+
+template<typename Rt>
+class future;
+
+template<typename Rt>
+class promise;
+
+/* future_state
+   shared state of a promise and its future; states are carved from a slab, one per result type, so that handing out a
+   future costs no trip to the general purpose heap. The status word tells whether a result came in and whether a
+   continuation or a waiter is attached, so that whichever side comes last gets to fire the continuation.
+*/
+template<typename Rt>
+class future_state
+{
+  public:
+  using  value_type = Rt;
+  using  store_type = typename std::conditional<std::is_void<Rt>::value, char, Rt>::type;
+  using  slab_type  = mmi::slab<future_state>;
+
+  static constexpr int status_value  = 1;   // result stored
+  static constexpr int status_broken = 2;   // all the promises went away without a result
+  static constexpr int status_ready  = status_value | status_broken;
+  static constexpr int status_then   = 4;   // continuation attached
+  static constexpr int status_wait   = 8;   // a thread is, or is about to be, blocked on the result
+  static constexpr int status_claim  = 16;  // a promise took the right to set the result
+  static constexpr int status_taken  = 32;  // the future was handed out
+
+  /* link
+     continuation attached to a state, fired by whichever thread completes the state
+  */
+  class link
+  {
+    public:
+    virtual void  run(future_state*) noexcept = 0;
+    virtual void  drop() noexcept = 0;
+  };
+
+  private:
+  std::atomic<int>  m_ref_count;
+  std::atomic<int>  m_promise_count;
+  std::atomic<int>  m_status;
+  link*             m_then;
+  std::mutex        m_wait_guard;
+  std::condition_variable m_wait_fence;
+  alignas(store_type) unsigned char m_data[sizeof(store_type)];
+
+  private:
+  static  slab_type& get_slab() noexcept {
+          static slab_type s_slab;
+          return s_slab;
+  }
+
+  /* fire()
+     run or drop the continuation, which holds the reference given up by the future
+  */
+  inline  void  fire() noexcept {
+          link* l_then = m_then;
+          m_then = nullptr;
+          if(m_status.load(std::memory_order_acquire) & status_value) {
+              l_then->run(this);
+          } else
+              l_then->drop();
+          release();
+  }
+
+  /* settle()
+     publish the outcome, then wake the waiters and fire the continuation, if any
+  */
+  inline  void  settle(int status) noexcept {
+          int l_status = m_status.fetch_or(status, std::memory_order_acq_rel);
+          if(l_status & status_wait) {
+              m_wait_guard.lock();
+              m_wait_guard.unlock();
+              m_wait_fence.notify_all();
+          }
+          if(l_status & status_then) {
+              fire();
+          }
+  }
+
+  public:
+  inline  future_state() noexcept:
+          m_ref_count(1),
+          m_promise_count(1),
+          m_status(0),
+          m_then(nullptr) {
+  }
+
+          future_state(const future_state&) noexcept = delete;
+          future_state(future_state&&) noexcept = delete;
+
+  inline  ~future_state() {
+          if constexpr (std::is_void<Rt>::value == false) {
+              if(m_status.load(std::memory_order_relaxed) & status_value) {
+                  get_value().~store_type();
+              }
+          }
+  }
+
+  static  future_state* make() noexcept {
+          return get_slab().emplace();
+  }
+
+  inline  void  acquire() noexcept {
+          m_ref_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  inline  void  release() noexcept {
+          if(m_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+              get_slab().remove(this);
+          }
+  }
+
+  inline  void  acquire_promise() noexcept {
+          m_promise_count.fetch_add(1, std::memory_order_relaxed);
+          acquire();
+  }
+
+  /* release_promise()
+     drop a promise; the last one to go breaks the state if no result was set
+  */
+  inline  void  release_promise() noexcept {
+          if(m_promise_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+              if((m_status.fetch_or(status_claim, std::memory_order_acq_rel) & status_claim) == 0) {
+                  settle(status_broken);
+              }
+          }
+          release();
+  }
+
+  /* take()
+     claim the future; there is only one per state
+  */
+  inline  bool  take() noexcept {
+          return (m_status.fetch_or(status_taken, std::memory_order_relaxed) & status_taken) == 0;
+  }
+
+  template<typename... Args>
+  inline  bool  set_value(Args&&... args) noexcept {
+          if((m_status.fetch_or(status_claim, std::memory_order_acq_rel) & status_claim) == 0) {
+              if constexpr (std::is_void<Rt>::value == false) {
+                  new(m_data) store_type(std::forward<Args>(args)...);
+              }
+              settle(status_value);
+              return true;
+          }
+          return false;
+  }
+
+  /* set_then()
+     attach the continuation; fires it right away if the state is already complete
+  */
+  inline  void  set_then(link* then) noexcept {
+          m_then = then;
+          if(m_status.fetch_or(status_then, std::memory_order_acq_rel) & status_ready) {
+              fire();
+          }
+  }
+
+  inline  void  wait() noexcept {
+          if((m_status.load(std::memory_order_acquire) & status_ready) == 0) {
+              std::unique_lock<std::mutex> l_wait_guard(m_wait_guard);
+              if((m_status.fetch_or(status_wait, std::memory_order_acq_rel) & status_ready) == 0) {
+                  m_wait_fence.wait(l_wait_guard, [this]() noexcept {
+                      return m_status.load(std::memory_order_acquire) & status_ready;
+                  });
+              }
+          }
+  }
+
+  inline  int   get_status() const noexcept {
+          return m_status.load(std::memory_order_acquire);
+  }
+
+  inline  store_type& get_value() noexcept {
+          return *std::launder(reinterpret_cast<store_type*>(m_data));
+  }
+
+          future_state& operator=(const future_state&) noexcept = delete;
+          future_state& operator=(future_state&&) noexcept = delete;
+};
+
+/* set_result()
+   run <fn> and hand its result to <promise>
+*/
+template<typename Ut, typename Fn, typename... Args>
+inline  void  set_result(promise<Ut>& promise, Fn& fn, Args&&... args) noexcept {
+        if constexpr (std::is_void<Ut>::value) {
+            fn(std::forward<Args>(args)...);
+            promise.set_value();
+        } else
+            promise.set_value(fn(std::forward<Args>(args)...));
+}
+
+/* then_result
+   result type of a continuation <Fn> taking the result of a future<Rt>
+*/
+template<typename Fn, typename Rt>
+struct then_result {
+  using type = typename std::invoke_result<Fn&, Rt&&>::type;
+};
+
+template<typename Fn>
+struct then_result<Fn, void> {
+  using type = typename std::invoke_result<Fn&>::type;
+};
+
+/* promise
+   producing side of a future; copies share the same state and the first result set wins, so that a promise can travel
+   inside callables that have to be copyable, such as std::function; when the last copy goes away without a result, the
+   future is broken
+*/
+template<typename Rt>
+class promise
+{
+  public:
+  using  state_type = future_state<Rt>;
+
+  private:
+  state_type*   m_state;
+
+  public:
+  inline  promise() noexcept:
+          m_state(state_type::make()) {
+  }
+
+  inline  promise(const promise& copy) noexcept:
+          m_state(copy.m_state) {
+          if(m_state != nullptr) {
+              m_state->acquire_promise();
+          }
+  }
+
+  inline  promise(promise&& copy) noexcept:
+          m_state(copy.m_state) {
+          copy.m_state = nullptr;
+  }
+
+  inline  ~promise() {
+          if(m_state != nullptr) {
+              m_state->release_promise();
+          }
+  }
+
+  /* get_future()
+     hand out the future bound to this promise; only the first call returns a valid one
+  */
+  inline  future<Rt> get_future() noexcept {
+          if(m_state != nullptr) {
+              if(m_state->take()) {
+                  m_state->acquire();
+                  return future<Rt>(m_state);
+              }
+          }
+          return future<Rt>();
+  }
+
+  template<typename... Args>
+  inline  bool  set_value(Args&&... args) noexcept {
+          if(m_state != nullptr) {
+              return m_state->set_value(std::forward<Args>(args)...);
+          }
+          return false;
+  }
+
+  inline  bool  is_valid() const noexcept {
+          return m_state != nullptr;
+  }
+
+  inline  promise& operator=(const promise& rhs) noexcept {
+          if(this != std::addressof(rhs)) {
+              promise l_copy(rhs);
+              std::swap(m_state, l_copy.m_state);
+          }
+          return *this;
+  }
+
+  inline  promise& operator=(promise&& rhs) noexcept {
+          std::swap(m_state, rhs.m_state);
+          return *this;
+  }
+};
+
+/* future
+   result of a task that may not have run yet; get() blocks until it has, then() attaches a follow-up that runs on the
+   thread completing the task, without going back through a queue
+*/
+template<typename Rt>
+class future
+{
+  public:
+  using  state_type = future_state<Rt>;
+
+  private:
+  /* continuation
+     link running a then() callable with the result of the state it is attached to, and passing its own result on
+  */
+  template<typename Fn, typename Ut>
+  class continuation: public state_type::link
+  {
+    using slab_type = mmi::slab<continuation>;
+
+    Fn            m_fn;
+    promise<Ut>   m_promise;
+
+    static  slab_type& get_slab() noexcept {
+            static slab_type s_slab;
+            return s_slab;
+    }
+
+    public:
+    template<typename Ft>
+    inline  continuation(Ft&& fn, promise<Ut>&& promise) noexcept:
+            m_fn(std::forward<Ft>(fn)),
+            m_promise(std::move(promise)) {
+    }
+
+    static  continuation* make(Fn&& fn, promise<Ut>&& promise) noexcept {
+            return get_slab().emplace(std::move(fn), std::move(promise));
+    }
+
+    virtual void  run(state_type* state) noexcept override {
+            if constexpr (std::is_void<Rt>::value) {
+                set_result(m_promise, m_fn);
+            } else
+                set_result(m_promise, m_fn, std::move(state->get_value()));
+            drop();
+    }
+
+    virtual void  drop() noexcept override {
+            get_slab().remove(this);
+    }
+  };
+
+  template<typename Fn>
+  using  then_type = typename then_result<Fn, Rt>::type;
+
+  private:
+  state_type*   m_state;
+
+  public:
+  inline  future() noexcept:
+          m_state(nullptr) {
+  }
+
+  inline  future(state_type* state) noexcept:
+          m_state(state) {
+  }
+
+          future(const future&) noexcept = delete;
+
+  inline  future(future&& copy) noexcept:
+          m_state(copy.m_state) {
+          copy.m_state = nullptr;
+  }
+
+  inline  ~future() {
+          if(m_state != nullptr) {
+              m_state->release();
+          }
+  }
+
+  /* then()
+     attach <fn> to run with the result, on the thread that completes this future, or right away if it is complete
+     already; the future is consumed and the result of <fn> comes out through the one returned; if this future is
+     broken, <fn> does not run and the returned one is broken too
+  */
+  template<typename Fn>
+  inline  auto  then(Fn&& fn) noexcept -> future<then_type<typename std::decay<Fn>::type>> {
+          using  fn_type     = typename std::decay<Fn>::type;
+          using  result_type = then_type<fn_type>;
+          if(m_state != nullptr) {
+              promise<result_type> l_promise;
+              future<result_type>  l_future = l_promise.get_future();
+              if(l_future.is_valid()) {
+                  auto l_then = continuation<fn_type, result_type>::make(fn_type(std::forward<Fn>(fn)), std::move(l_promise));
+                  if(l_then != nullptr) {
+                      state_type* l_state = m_state;
+                      m_state = nullptr;
+                      l_state->set_then(l_then);
+                      return l_future;
+                  }
+              }
+          }
+          return future<result_type>();
+  }
+
+  inline  void  wait() noexcept {
+          if(m_state != nullptr) {
+              m_state->wait();
+          }
+  }
+
+  /* get()
+     wait for the result and move it out; a broken future yields a default constructed value
+  */
+  inline  Rt    get() noexcept {
+          if(m_state != nullptr) {
+              m_state->wait();
+              if constexpr (std::is_void<Rt>::value == false) {
+                  if(m_state->get_status() & state_type::status_value) {
+                      return std::move(m_state->get_value());
+                  }
+              }
+          }
+          if constexpr (std::is_void<Rt>::value == false) {
+              return Rt();
+          }
+  }
+
+  inline  bool  is_valid() const noexcept {
+          return m_state != nullptr;
+  }
+
+  inline  bool  is_ready() const noexcept {
+          return (m_state != nullptr) && (m_state->get_status() & state_type::status_ready);
+  }
+
+  /* has_value()
+     check if the future completed with a result, as opposed to being broken
+  */
+  inline  bool  has_value() const noexcept {
+          return (m_state != nullptr) && (m_state->get_status() & state_type::status_value);
+  }
+
+          future& operator=(const future&) noexcept = delete;
+
+  inline  future& operator=(future&& rhs) noexcept {
+          std::swap(m_state, rhs.m_state);
+          return *this;
+  }
+};
+
+/* async_task
+   callable wrapping <fn> so that its result goes into a promise; copyable as long as <fn> is, so that it can be held
+   by any callable type a queue may use
+*/
+template<typename Fn, typename Rt>
+class async_task
+{
+  Fn            m_fn;
+  promise<Rt>   m_promise;
+
+  public:
+  template<typename Ft>
+  inline  async_task(Ft&& fn, promise<Rt>&& promise) noexcept:
+          m_fn(std::forward<Ft>(fn)),
+          m_promise(std::move(promise)) {
+  }
+
+  inline  void  operator()() noexcept {
+          set_result(m_promise, m_fn);
+  }
+};
+
+/* schedule_async()
+   schedule <fn> on <queue> (a queue, or a pool) and return the future of its result, or an invalid future if the
+   queue would not take it; the callable type of the queue must be constructible from a copyable callable, as
+   std::function is
+*/
+template<typename Qt, typename Fn>
+inline  auto  schedule_async(Qt& queue, Fn&& fn) noexcept -> future<typename std::invoke_result<typename std::decay<Fn>::type&>::type> {
+        using  fn_type     = typename std::decay<Fn>::type;
+        using  result_type = typename std::invoke_result<fn_type&>::type;
+        promise<result_type> l_promise;
+        future<result_type>  l_future = l_promise.get_future();
+        if(l_future.is_valid()) {
+            if(queue.schedule(async_task<fn_type, result_type>(std::forward<Fn>(fn), std::move(l_promise)))) {
+                return l_future;
+            }
+        }
+        return future<result_type>();
+}
+
+/*namespace pxi*/ }
+#endif
@@ -23,7 +23,9 @@
 **/
 #include <pxi.h>
 #include "queue.h"
+#include "topology.h"
 #include <array>
+#include <iterator>
 #include <limits>
 
 namespace pxi {
@@ -34,14 +36,19 @@ class pool
   static_assert(Size > 1, "pool should reserve at least 2 queues");
   static_assert(Size < std::numeric_limits<int>::max(), "pool can reserve at most INT_MAX queues");
 
+  static_assert((Policy != pxi_policy_steal) || std::is_same<Ct, std::thread>::value, "work stealing needs threaded queues");
+  static_assert((Policy != pxi_policy_weight) || has_weight_support<Xt>::value, "weighted scheduling needs callables with get_weight()");
+
   public:
   using                 queue_type = queue<Xt, Ct>;
+  using                 consumer_type = consumer<Xt, Ct>;
   static constexpr int  queue_size = Size; 
 
   private:
   int         m_queue_index;
   int         m_queue_count;
   queue_type  m_queue_list[Size];
+  consumer_type* m_peer_list[Size];
 
   protected:
   public:
@@ -60,12 +67,31 @@ class pool
                   m_queue_list[i].set_params(std::forward<Args>(args)...);
               }
           }
+          if constexpr (Policy == pxi_policy_steal) {
+              int i;
+              for(i = 0; i < m_queue_count; i++) {
+                  m_peer_list[i] = std::addressof(m_queue_list[i]);
+              }
+              for(i = 0; i < m_queue_count; i++) {
+                  m_queue_list[i].set_peers(m_peer_list, m_queue_count);
+              }
+          }
   }
 
           pool(const pool&) noexcept = delete;
           pool(pool&&) noexcept = delete;
 
   inline  ~pool() {
+          if constexpr (Policy == pxi_policy_steal) {
+              // workers reach into each other's queues: stop all of them before any queue goes away
+              int i;
+              for(i = 0; i < m_queue_count; i++) {
+                  static_cast<consumer_type&>(m_queue_list[i]).suspend();
+              }
+              for(i = 0; i < m_queue_count; i++) {
+                  static_cast<consumer_type&>(m_queue_list[i]).join();
+              }
+          }
   }
 
   inline  queue_type& get(int index) noexcept {
@@ -85,7 +111,7 @@ class pool
   inline  bool schedule(Args&&... args) noexcept {
           // fast scheduling
           // try to find a less busy queue than the current one, but not necessarily the least busiest one
-          if constexpr (Policy == pxi_policy_fast) {
+          if constexpr ((Policy == pxi_policy_fast) || (Policy == pxi_policy_steal)) {
               int   l_fuel     = m_queue_count;
               float l_load_min = std::numeric_limits<float>::infinity();
               float l_load_new;
@@ -125,9 +151,164 @@ class pool
               }
           }
 
+          // weight scheduling
+          // find the queue with the least weighted load, and of those the one with the fewest tasks
+          if constexpr (Policy == pxi_policy_weight) {
+              int   l_index_new;
+              float l_load_new = 0;
+              float l_load_min = std::numeric_limits<float>::infinity();
+              int   l_count_min = 0;
+              for(l_index_new = 0; l_index_new < m_queue_count; l_index_new++) {
+                  l_load_new = m_queue_list[l_index_new].get_load();
+                  if(l_load_new <= l_load_min) {
+                      int l_count_new = m_queue_list[l_index_new].count();
+                      if((l_load_new < l_load_min) ||
+                          (l_count_new < l_count_min)) {
+                          m_queue_index = l_index_new;
+                          l_load_min  = l_load_new;
+                          l_count_min = l_count_new;
+                      }
+                  }
+              }
+          }
+
           return m_queue_list[m_queue_index].schedule(std::forward<Args>(args)...);
   }
 
+  /* schedule_bulk()
+     split the callables in the range [<first>, <last>) across the queues so as to even out their loads, handing each
+     queue its share in one go; returns how many were taken, always from the front of the range
+  */
+  template<typename It>
+  inline  int  schedule_bulk(It first, It last) noexcept {
+          int   l_done = 0;
+          float l_load_list[Size];
+          float l_load_sum = 0.0f;
+          for(int i_queue = 0; i_queue < m_queue_count; i_queue++) {
+              l_load_list[i_queue] = m_queue_list[i_queue].get_load();
+              l_load_sum += l_load_list[i_queue];
+          }
+          if constexpr (has_weight_support<Xt>::value) {
+              for(It i_task = first; i_task != last; ++i_task) {
+                  l_load_sum += queue_type::get_weight(*i_task);
+              }
+          } else
+              l_load_sum += static_cast<float>(std::distance(first, last));
+          // fill the queues up to a common level; those already above it get nothing
+          float l_level = l_load_sum / static_cast<float>(m_queue_count);
+          int   l_fuel  = m_queue_count;
+          while(l_fuel && (first != last)) {
+              float l_room = l_level - l_load_list[m_queue_index];
+              if(l_room > 0.0f) {
+                  It  l_next = first;
+                  while((l_next != last) && (l_room > 0.0f)) {
+                      l_room -= queue_type::get_weight(*l_next);
+                      ++l_next;
+                  }
+                  int l_take = m_queue_list[m_queue_index].schedule_bulk(first, l_next);
+                  std::advance(first, l_take);
+                  l_done += l_take;
+              }
+              ++m_queue_index;
+              if(m_queue_index == m_queue_count) {
+                  m_queue_index = 0;
+              }
+              --l_fuel;
+          }
+          return l_done;
+  }
+
+  /* schedule_async()
+     schedule <fn> and return the future of its result, see pxi::schedule_async()
+  */
+  template<typename Fn>
+  inline  auto schedule_async(Fn&& fn) noexcept {
+          return pxi::schedule_async(*this, std::forward<Fn>(fn));
+  }
+
+  /* cancel()
+     cancel the task with the given id, wherever it was scheduled; returns pxi_cancel_done as soon as a queue had it,
+     pxi_cancel_pending if it may still be on its way to some queue, pxi_cancel_none otherwise, see consumer::cancel()
+  */
+  inline  int  cancel(std::size_t id) noexcept {
+          int  l_result = pxi_cancel_none;
+          for(int i_queue = 0; i_queue < m_queue_count; i_queue++) {
+              int l_cancel = m_queue_list[i_queue].cancel(id);
+              if(l_cancel == pxi_cancel_done) {
+                  return l_cancel;
+              }
+              if(l_cancel == pxi_cancel_pending) {
+                  l_result = l_cancel;
+              }
+          }
+          return l_result;
+  }
+
+  /* set_affinity()
+     place the worker threads:
+     pxi_affinity_none - let the system move them around;
+     pxi_affinity_core - give each queue a cpu of its own, going through distinct physical cores before using their
+                         hyperthread siblings; with a <node>, only the cpus of that node are used;
+     pxi_affinity_node - keep each queue on the cpus of a NUMA node: all of them on <node> if given, otherwise spread
+                         round robin across the nodes that have cpus.
+  */
+  inline  bool set_affinity(int mode, int node = -1) noexcept {
+          if constexpr (std::is_same<Ct, std::thread>::value) {
+              const topology& l_topology = topology::get_default();
+              cpu_set_t       l_set;
+              bool            l_result = true;
+              if((node >= l_topology.get_node_count()) ||
+                  (l_topology.get_cpu_count(node) == 0)) {
+                  node = -1;
+              }
+              for(int i_queue = 0; i_queue < m_queue_count; i_queue++) {
+                  consumer_type& l_queue = m_queue_list[i_queue];
+                  if(mode == pxi_affinity_core) {
+                      CPU_ZERO(std::addressof(l_set));
+                      CPU_SET(l_topology.get_cpu(i_queue, node), std::addressof(l_set));
+                      l_result &= l_queue.set_affinity(std::addressof(l_set));
+                  } else
+                  if(mode == pxi_affinity_node) {
+                      int l_node = node;
+                      if(l_node < 0) {
+                          l_node = l_topology.get_node(i_queue);
+                      }
+                      if(l_topology.get_node_set(l_node, l_set)) {
+                          l_result &= l_queue.set_affinity(std::addressof(l_set));
+                      } else
+                          l_result &= l_queue.set_affinity(nullptr);
+                  } else
+                      l_result &= l_queue.set_affinity(nullptr);
+              }
+              return l_result;
+          } else
+              return false;
+  }
+
+  /* set_affinity_near()
+     place the worker threads as set_affinity() does, on the NUMA node holding the memory at <p>, so that the queues
+     run next to the data they process
+  */
+  inline  bool set_affinity_near(const void* p, int mode = pxi_affinity_node) noexcept {
+          return set_affinity(mode, topology::get_node_of(p));
+  }
+
+  /* get_stats()
+     snapshot of the statistics of all the queues merged together, see consumer::get_stats()
+  */
+  inline  bool get_stats(stats_data& data) const noexcept {
+          stats_data l_data;
+          bool       l_result = false;
+          data.reset();
+          for(int i_queue = 0; i_queue < m_queue_count; i_queue++) {
+              if(m_queue_list[i_queue].get_stats(l_data)) {
+                  l_result = true;
+              }
+              data.merge(l_data);
+          }
+          return l_result;
+  }
+
   inline  queue_type& operator[](int index) noexcept {
           return get(index);
   }
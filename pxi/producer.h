@@ -24,11 +24,31 @@
 #include <pxi.h>
 #include <vector>
 #include <thread>
+#include <atomic>
+#include <mutex>
 #include <condition_variable>
 #include <limits>
+#include <type_traits>
 
 namespace pxi {
 
+/* has_weight_support
+   detect if custom callable type supports weight measurement through a const get_weight(), in order to enable more
+   accurate scheduling
+*/
+template<typename Xt>
+class has_weight_support
+{
+  template<typename Ot>
+  static  auto test(int) -> decltype(std::declval<const Ot&>().get_weight());
+
+  template<typename Ot>
+  static  auto test(...) -> void;
+
+  public:
+  static  constexpr bool value = std::is_convertible<decltype(test<Xt>(0)), float>::value;
+};
+
 template<typename Xt, typename Ct>
 class producer
 {
@@ -52,10 +72,32 @@ class producer
   protected:
   list_type   m_task_list;
 
+  protected:
+  /* add_load()
+     std::atomic<float> has no fetch_add() before c++20
+  */
+  inline  void   add_load(float value) noexcept {
+          float l_load = m_load.load(std::memory_order_relaxed);
+          while(m_load.compare_exchange_weak(l_load, l_load + value, std::memory_order_relaxed) == false) {
+          }
+  }
+
   public:
+  /* get_weight()
+     share of the load a task accounts for while it is queued or running: its weight, if the callable type has one,
+     else 1
+  */
+  static  float  get_weight(const callable_type& callable) noexcept {
+          if constexpr (has_weight_support<Xt>::value) {
+              return callable.get_weight();
+          } else
+              return 1.0f;
+  }
+
   inline  producer(int reserve) noexcept:
           m_capacity_min(global::cache_small_max),
-          m_capacity_max(std::numeric_limits<int>::max()) {
+          m_capacity_max(std::numeric_limits<int>::max()),
+          m_load(0.0f) {
           if(reserve < m_capacity_min) {
               m_task_list.reserve(m_capacity_min);
           } else
@@ -69,7 +111,7 @@ class producer
   }
 
   inline  float  get_load() const noexcept {
-          return m_load;
+          return m_load.load(std::memory_order_relaxed);
   }
 
           producer& operator=(const producer&) noexcept = delete;
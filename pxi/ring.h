@@ -0,0 +1,228 @@
+#ifndef pxi_ring_h
+#define pxi_ring_h
+/** 
+    Copyright (c) 2021, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include <pxi.h>
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace pxi {
+
+/* ring
+   bounded lock-free queue, with any number of producers and a single consumer;
+   each cell carries a sequence number telling whose turn it is to use it: producers claim a cell by advancing the
+   head, construct the item in place and publish it by bumping the sequence; the consumer takes items at the tail and
+   hands the cells back to the producers one lap later
+*/
+template<typename Xt>
+class ring
+{
+  public:
+  using  node_type = Xt;
+
+  static constexpr std::size_t size_min = 64u;
+
+  private:
+  struct cell {
+    std::atomic<std::size_t>  seq;
+    alignas(Xt) unsigned char data[sizeof(Xt)];
+  };
+
+  private:
+  cell*                     m_cell_list;
+  std::size_t               m_cell_mask;
+  alignas(64) std::atomic<std::size_t> m_head;
+  alignas(64) std::atomic<std::size_t> m_tail;
+
+  private:
+  inline  node_type* get_node(cell& cell) noexcept {
+          return std::launder(reinterpret_cast<node_type*>(cell.data));
+  }
+
+  public:
+  inline  ring(std::size_t size) noexcept:
+          m_cell_list(nullptr),
+          m_cell_mask(0),
+          m_head(0),
+          m_tail(0) {
+          std::size_t l_size = size_min;
+          while(l_size < size) {
+              l_size <<= 1;
+          }
+          m_cell_list = new(std::nothrow) cell[l_size];
+          if(m_cell_list != nullptr) {
+              for(std::size_t i_cell = 0; i_cell < l_size; i_cell++) {
+                  m_cell_list[i_cell].seq.store(i_cell, std::memory_order_relaxed);
+              }
+              m_cell_mask = l_size - 1;
+          }
+  }
+
+          ring(const ring&) noexcept = delete;
+          ring(ring&&) noexcept = delete;
+
+  inline  ~ring() {
+          if(m_cell_list != nullptr) {
+              while(pop([](node_type&) noexcept {})) {
+              }
+              delete[] m_cell_list;
+          }
+  }
+
+  /* push()
+     construct a new item at the head of the ring from <args>; fails without touching <args> if the ring is full
+  */
+  template<typename... Args>
+  inline  bool push(Args&&... args) noexcept {
+          if(m_cell_list != nullptr) {
+              std::size_t l_head = m_head.load(std::memory_order_relaxed);
+              while(true) {
+                  cell&          l_cell = m_cell_list[l_head & m_cell_mask];
+                  std::size_t    l_seq  = l_cell.seq.load(std::memory_order_acquire);
+                  std::ptrdiff_t l_diff = static_cast<std::ptrdiff_t>(l_seq - l_head);
+                  if(l_diff == 0) {
+                      if(m_head.compare_exchange_weak(l_head, l_head + 1, std::memory_order_relaxed)) {
+                          new(l_cell.data) node_type(std::forward<Args>(args)...);
+                          l_cell.seq.store(l_head + 1, std::memory_order_release);
+                          return true;
+                      }
+                  } else
+                  if(l_diff < 0) {
+                      return false;
+                  } else
+                      l_head = m_head.load(std::memory_order_relaxed);
+              }
+          }
+          return false;
+  }
+
+  /* push_bulk()
+     claim up to <count> consecutive cells at the head of the ring with a single CAS and construct the items in them
+     from the range starting at <first>, which is advanced past the items taken; returns the number of items pushed,
+     which may fall short of <count> when the ring is nearly full
+  */
+  template<typename It>
+  inline  std::size_t push_bulk(It& first, std::size_t count) noexcept {
+          if((m_cell_list != nullptr) && (count > 0)) {
+              std::size_t l_head = m_head.load(std::memory_order_relaxed);
+              while(true) {
+                  std::size_t l_tail = m_tail.load(std::memory_order_relaxed);
+                  if(l_tail > l_head) {
+                      l_head = m_head.load(std::memory_order_relaxed);
+                      continue;
+                  }
+                  std::size_t l_free = m_cell_mask + 1 - (l_head - l_tail);
+                  std::size_t l_size = count < l_free ? count : l_free;
+                  if(l_size == 0) {
+                      return 0;
+                  }
+                  // cells are handed back in order, so if the last cell of the run is free, all of them are
+                  std::size_t    l_last = l_head + l_size - 1;
+                  std::size_t    l_seq  = m_cell_list[l_last & m_cell_mask].seq.load(std::memory_order_acquire);
+                  std::ptrdiff_t l_diff = static_cast<std::ptrdiff_t>(l_seq - l_last);
+                  if(l_diff == 0) {
+                      if(m_head.compare_exchange_weak(l_head, l_head + l_size, std::memory_order_relaxed)) {
+                          for(std::size_t i_node = l_head; i_node <= l_last; i_node++) {
+                              cell& l_cell = m_cell_list[i_node & m_cell_mask];
+                              new(l_cell.data) node_type(*first);
+                              l_cell.seq.store(i_node + 1, std::memory_order_release);
+                              ++first;
+                          }
+                          return l_size;
+                      }
+                  } else
+                  if(l_diff < 0) {
+                      return 0;
+                  } else
+                      l_head = m_head.load(std::memory_order_relaxed);
+              }
+          }
+          return 0;
+  }
+
+  /* pop()
+     consumer side: pass the item at the tail of the ring to <fn>, then destroy it and release its cell
+  */
+  template<typename Fn>
+  inline  bool pop(Fn&& fn) noexcept {
+          std::size_t l_tail = m_tail.load(std::memory_order_relaxed);
+          cell&       l_cell = m_cell_list[l_tail & m_cell_mask];
+          if(l_cell.seq.load(std::memory_order_acquire) == l_tail + 1) {
+              node_type* l_node = get_node(l_cell);
+              fn(*l_node);
+              l_node->~node_type();
+              l_cell.seq.store(l_tail + m_cell_mask + 1, std::memory_order_release);
+              m_tail.store(l_tail + 1, std::memory_order_relaxed);
+              return true;
+          }
+          return false;
+  }
+
+  /* is_empty()
+     consumer side: check if there is an item ready at the tail of the ring
+  */
+  inline  bool is_empty() const noexcept {
+          if(m_cell_list != nullptr) {
+              std::size_t l_tail = m_tail.load(std::memory_order_relaxed);
+              return m_cell_list[l_tail & m_cell_mask].seq.load(std::memory_order_acquire) != l_tail + 1;
+          }
+          return true;
+  }
+
+  /* get_head_index()
+     running count of the cells claimed by producers so far; once get_tail_index() has caught up with a value taken
+     here, every item pushed before it was taken has been popped
+  */
+  inline  std::size_t get_head_index() const noexcept {
+          return m_head.load(std::memory_order_acquire);
+  }
+
+  /* get_tail_index()
+     consumer side: running count of the items popped so far
+  */
+  inline  std::size_t get_tail_index() const noexcept {
+          return m_tail.load(std::memory_order_relaxed);
+  }
+
+  /* get_count()
+     approximate number of items in the ring, usable from any thread
+  */
+  inline  std::size_t get_count() const noexcept {
+          std::size_t l_tail = m_tail.load(std::memory_order_relaxed);
+          std::size_t l_head = m_head.load(std::memory_order_relaxed);
+          if(l_head > l_tail) {
+              return l_head - l_tail;
+          }
+          return 0;
+  }
+
+  inline  std::size_t get_capacity() const noexcept {
+          return m_cell_list != nullptr ? m_cell_mask + 1 : 0;
+  }
+
+          ring& operator=(const ring&) noexcept = delete;
+          ring& operator=(ring&&) noexcept = delete;
+};
+
+/*namespace pxi*/ }
+#endif
@@ -0,0 +1,349 @@
+#ifndef pxi_stats_h
+#define pxi_stats_h
+/** 
+    Copyright (c) 2021, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include <pxi.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <log.h>
+
+namespace pxi {
+
+/* get_clock()
+   monotonic time in nanoseconds
+*/
+inline  std::int64_t get_clock() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* stamp
+   time a task was scheduled, carried along with the task when the statistics are compiled in, empty otherwise
+*/
+template<bool Enable>
+class stamp
+{
+  public:
+  inline  stamp() noexcept {
+  }
+
+  inline  std::int64_t get_time() const noexcept {
+          return 0;
+  }
+};
+
+template<>
+class stamp<true>
+{
+  std::int64_t m_time;
+
+  public:
+  inline  stamp() noexcept:
+          m_time(get_clock()) {
+  }
+
+  inline  std::int64_t get_time() const noexcept {
+          return m_time;
+  }
+};
+
+/* histogram_data
+   copy of a histogram: bucket <i> counts the durations from 2^i up to 2^(i+1) nanoseconds, the first one also counts
+   the shorter ones and the last one all the longer ones
+*/
+struct histogram_data
+{
+  static constexpr int bucket_count = 40;
+
+  std::uint64_t bucket_list[bucket_count];
+  std::uint64_t count;
+  std::uint64_t sum;
+  std::uint64_t max;
+
+  inline  void  reset() noexcept {
+          for(auto& i_bucket : bucket_list) {
+              i_bucket = 0;
+          }
+          count = 0;
+          sum = 0;
+          max = 0;
+  }
+
+  inline  void  merge(const histogram_data& data) noexcept {
+          for(int i_bucket = 0; i_bucket < bucket_count; i_bucket++) {
+              bucket_list[i_bucket] += data.bucket_list[i_bucket];
+          }
+          count += data.count;
+          sum += data.sum;
+          if(data.max > max) {
+              max = data.max;
+          }
+  }
+
+  inline  std::uint64_t get_mean() const noexcept {
+          return count ? sum / count : 0;
+  }
+
+  /* get_percentile()
+     upper bound, in nanoseconds, of the bucket holding the <p>th percentile
+  */
+  inline  std::uint64_t get_percentile(float p) const noexcept {
+          std::uint64_t l_rank = static_cast<std::uint64_t>(static_cast<float>(count) * p / 100.0f);
+          std::uint64_t l_seen = 0;
+          for(int i_bucket = 0; i_bucket < bucket_count; i_bucket++) {
+              l_seen += bucket_list[i_bucket];
+              if(l_seen > l_rank) {
+                  std::uint64_t l_bound = std::uint64_t(2) << i_bucket;
+                  return l_bound < max ? l_bound : max;
+              }
+          }
+          return max;
+  }
+};
+
+/* histogram
+   power of two histogram of durations; written by a single thread, readable from any
+*/
+class histogram
+{
+  std::atomic<std::uint64_t> m_bucket_list[histogram_data::bucket_count];
+  std::atomic<std::uint64_t> m_count;
+  std::atomic<std::uint64_t> m_sum;
+  std::atomic<std::uint64_t> m_max;
+
+  private:
+  static  void  bump(std::atomic<std::uint64_t>& value, std::uint64_t delta) noexcept {
+          value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  }
+
+  public:
+  inline  histogram() noexcept:
+          m_count(0),
+          m_sum(0),
+          m_max(0) {
+          for(auto& i_bucket : m_bucket_list) {
+              i_bucket.store(0, std::memory_order_relaxed);
+          }
+  }
+
+  inline  void  add(std::int64_t time) noexcept {
+          std::uint64_t l_time   = time > 0 ? static_cast<std::uint64_t>(time) : 0;
+          int           l_bucket = l_time > 1 ? 63 - __builtin_clzll(l_time) : 0;
+          if(l_bucket >= histogram_data::bucket_count) {
+              l_bucket = histogram_data::bucket_count - 1;
+          }
+          bump(m_bucket_list[l_bucket], 1);
+          bump(m_count, 1);
+          bump(m_sum, l_time);
+          if(l_time > m_max.load(std::memory_order_relaxed)) {
+              m_max.store(l_time, std::memory_order_relaxed);
+          }
+  }
+
+  inline  void  get(histogram_data& data) const noexcept {
+          for(int i_bucket = 0; i_bucket < histogram_data::bucket_count; i_bucket++) {
+              data.bucket_list[i_bucket] = m_bucket_list[i_bucket].load(std::memory_order_relaxed);
+          }
+          data.count = m_count.load(std::memory_order_relaxed);
+          data.sum = m_sum.load(std::memory_order_relaxed);
+          data.max = m_max.load(std::memory_order_relaxed);
+  }
+};
+
+/* stats_data
+   snapshot of the statistics of a queue, or of a whole pool
+*/
+struct stats_data
+{
+  histogram_data  wait;           // time from scheduling a task to starting it
+  histogram_data  run;            // time spent running a task
+  std::uint64_t   steal_count;    // tasks taken from peers
+  std::uint64_t   stolen_count;   // tasks taken by peers
+  std::uint64_t   idle_count;     // times the worker ran out of tasks and went to wait
+  std::uint64_t   wake_count;     // times the worker was woken up by a new task
+  int             depth;          // tasks waiting or running when the snapshot was taken
+  int             depth_max;      // most tasks seen waiting or running
+
+  inline  void  reset() noexcept {
+          wait.reset();
+          run.reset();
+          steal_count = 0;
+          stolen_count = 0;
+          idle_count = 0;
+          wake_count = 0;
+          depth = 0;
+          depth_max = 0;
+  }
+
+  inline  void  merge(const stats_data& data) noexcept {
+          wait.merge(data.wait);
+          run.merge(data.run);
+          steal_count += data.steal_count;
+          stolen_count += data.stolen_count;
+          idle_count += data.idle_count;
+          wake_count += data.wake_count;
+          depth += data.depth;
+          if(data.depth_max > depth_max) {
+              depth_max = data.depth_max;
+          }
+  }
+
+  /* print()
+     dump the snapshot through printlog(), times in microseconds
+  */
+  inline  void  print(const char* name) const noexcept {
+          printlog(
+              "[%s] depth: %d (max %d); tasks: %llu; steal: %llu; stolen: %llu; idle: %llu; wake: %llu",
+              __FILE__, __LINE__,
+              name, depth, depth_max, static_cast<unsigned long long>(run.count),
+              static_cast<unsigned long long>(steal_count), static_cast<unsigned long long>(stolen_count),
+              static_cast<unsigned long long>(idle_count), static_cast<unsigned long long>(wake_count)
+          );
+          print(name, "wait", wait);
+          print(name, "run", run);
+  }
+
+  static  void  print(const char* name, const char* what, const histogram_data& data) noexcept {
+          printlog(
+              "[%s] %-4s us: mean %.3f; p50 %.3f; p90 %.3f; p99 %.3f; max %.3f",
+              __FILE__, __LINE__,
+              name, what,
+              data.get_mean() / 1000.0, data.get_percentile(50.0f) / 1000.0, data.get_percentile(90.0f) / 1000.0,
+              data.get_percentile(99.0f) / 1000.0, data.max / 1000.0
+          );
+  }
+};
+
+/* stats
+   statistics of a threaded queue; all the counters belong to the worker thread, except for the count of tasks taken
+   by peers. With Enable false, every call compiles to nothing.
+*/
+template<bool Enable>
+class stats
+{
+  public:
+  inline  void  add_wait(const stamp<Enable>&) noexcept {
+  }
+
+  inline  std::int64_t get_start() const noexcept {
+          return 0;
+  }
+
+  inline  void  add_run(std::int64_t) noexcept {
+  }
+
+  inline  void  add_steal() noexcept {
+  }
+
+  inline  void  add_stolen() noexcept {
+  }
+
+  inline  void  add_idle() noexcept {
+  }
+
+  inline  void  add_wake() noexcept {
+  }
+
+  inline  void  add_depth(int) noexcept {
+  }
+
+  inline  bool  get(stats_data&) const noexcept {
+          return false;
+  }
+};
+
+template<>
+class stats<true>
+{
+  histogram         m_wait;
+  histogram         m_run;
+  std::atomic<std::uint64_t> m_steal_count;
+  std::atomic<std::uint64_t> m_stolen_count;
+  std::atomic<std::uint64_t> m_idle_count;
+  std::atomic<std::uint64_t> m_wake_count;
+  std::atomic<int>  m_depth_max;
+
+  private:
+  static  void  bump(std::atomic<std::uint64_t>& value) noexcept {
+          value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  public:
+  inline  stats() noexcept:
+          m_wait(),
+          m_run(),
+          m_steal_count(0),
+          m_stolen_count(0),
+          m_idle_count(0),
+          m_wake_count(0),
+          m_depth_max(0) {
+  }
+
+  inline  void  add_wait(const stamp<true>& stamp) noexcept {
+          m_wait.add(get_clock() - stamp.get_time());
+  }
+
+  inline  std::int64_t get_start() const noexcept {
+          return get_clock();
+  }
+
+  inline  void  add_run(std::int64_t start) noexcept {
+          m_run.add(get_clock() - start);
+  }
+
+  inline  void  add_steal() noexcept {
+          bump(m_steal_count);
+  }
+
+  // called by the thief, so several threads may race here
+  inline  void  add_stolen() noexcept {
+          m_stolen_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  inline  void  add_idle() noexcept {
+          bump(m_idle_count);
+  }
+
+  inline  void  add_wake() noexcept {
+          bump(m_wake_count);
+  }
+
+  inline  void  add_depth(int depth) noexcept {
+          if(depth > m_depth_max.load(std::memory_order_relaxed)) {
+              m_depth_max.store(depth, std::memory_order_relaxed);
+          }
+  }
+
+  inline  bool  get(stats_data& data) const noexcept {
+          m_wait.get(data.wait);
+          m_run.get(data.run);
+          data.steal_count = m_steal_count.load(std::memory_order_relaxed);
+          data.stolen_count = m_stolen_count.load(std::memory_order_relaxed);
+          data.idle_count = m_idle_count.load(std::memory_order_relaxed);
+          data.wake_count = m_wake_count.load(std::memory_order_relaxed);
+          data.depth_max = m_depth_max.load(std::memory_order_relaxed);
+          return true;
+  }
+};
+
+/*namespace pxi*/ }
+#endif
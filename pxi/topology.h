@@ -0,0 +1,256 @@
+#ifndef pxi_topology_h
+#define pxi_topology_h
+/** 
+    Copyright (c) 2021, wicked systems
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+    conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+      disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of wicked systems nor the names of its contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+    EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#include <pxi.h>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace pxi {
+
+/* topology
+   layout of the online cpus, as found in sysfs: the NUMA node, package and core of each; cpus are ranked so that
+   taking them in order walks the distinct physical cores of a node before their hyperthread siblings, and goes
+   through the nodes one after the other. Machines without sysfs NUMA information are taken as a single node.
+*/
+class topology
+{
+  public:
+  struct cpu_info {
+    int   cpu;
+    int   node;
+    int   package;
+    int   core;
+    int   sibling;    // rank of the cpu among the hardware threads of its core
+  };
+
+  private:
+  std::vector<cpu_info> m_cpu_list;
+  int   m_node_count;
+
+  private:
+  static  int   read_int(const char* path, int value) noexcept {
+          if(FILE* l_file = std::fopen(path, "r"); l_file != nullptr) {
+              if(std::fscanf(l_file, "%d", std::addressof(value)) != 1) {
+                  value = -1;
+              }
+              std::fclose(l_file);
+          }
+          return value;
+  }
+
+  /* read_set()
+     parse a sysfs cpu list, such as "0-3,8-11"
+  */
+  static  bool  read_set(const char* path, cpu_set_t& set) noexcept {
+          CPU_ZERO(std::addressof(set));
+          if(FILE* l_file = std::fopen(path, "r"); l_file != nullptr) {
+              int  l_lo;
+              int  l_hi;
+              bool l_result = false;
+              while(std::fscanf(l_file, "%d", std::addressof(l_lo)) == 1) {
+                  l_hi = l_lo;
+                  int l_sep = std::fgetc(l_file);
+                  if(l_sep == '-') {
+                      if(std::fscanf(l_file, "%d", std::addressof(l_hi)) != 1) {
+                          break;
+                      }
+                      l_sep = std::fgetc(l_file);
+                  }
+                  for(int i_cpu = l_lo; (i_cpu <= l_hi) && (i_cpu < CPU_SETSIZE); i_cpu++) {
+                      CPU_SET(i_cpu, std::addressof(set));
+                      l_result = true;
+                  }
+                  if(l_sep != ',') {
+                      break;
+                  }
+              }
+              std::fclose(l_file);
+              return l_result;
+          }
+          return false;
+  }
+
+  public:
+  inline  topology() noexcept:
+          m_cpu_list(),
+          m_node_count(1) {
+          char      l_path[128];
+          cpu_set_t l_online;
+          if(read_set("/sys/devices/system/cpu/online", l_online) == false) {
+              CPU_ZERO(std::addressof(l_online));
+              if(sched_getaffinity(0, sizeof(l_online), std::addressof(l_online)) != 0) {
+                  CPU_SET(0, std::addressof(l_online));
+              }
+          }
+          for(int i_cpu = 0; i_cpu < CPU_SETSIZE; i_cpu++) {
+              if(CPU_ISSET(i_cpu, std::addressof(l_online))) {
+                  cpu_info l_info{i_cpu, 0, 0, i_cpu, 0};
+                  std::snprintf(l_path, sizeof(l_path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i_cpu);
+                  l_info.package = read_int(l_path, 0);
+                  std::snprintf(l_path, sizeof(l_path), "/sys/devices/system/cpu/cpu%d/topology/core_id", i_cpu);
+                  l_info.core = read_int(l_path, i_cpu);
+                  m_cpu_list.push_back(l_info);
+              }
+          }
+          // nodes: look for the node each cpu belongs to; node ids may be sparse, with offline nodes or memory only
+          // nodes (such as HBM or CXL memory) in between, so only the ids listed as online are visited
+          cpu_set_t l_node_online;
+          if((read_set("/sys/devices/system/node/online", l_node_online) == false) &&
+              (read_set("/sys/devices/system/node/possible", l_node_online) == false)) {
+              CPU_ZERO(std::addressof(l_node_online));
+          }
+          for(int i_node = 0; i_node < CPU_SETSIZE; i_node++) {
+              if(CPU_ISSET(i_node, std::addressof(l_node_online))) {
+                  cpu_set_t l_node_set;
+                  std::snprintf(l_path, sizeof(l_path), "/sys/devices/system/node/node%d/cpulist", i_node);
+                  if(read_set(l_path, l_node_set)) {
+                      for(auto& i_info : m_cpu_list) {
+                          if(CPU_ISSET(i_info.cpu, std::addressof(l_node_set))) {
+                              i_info.node = i_node;
+                          }
+                      }
+                  }
+                  m_node_count = i_node + 1;
+              }
+          }
+          for(auto& i_info : m_cpu_list) {
+              for(auto& i_peer : m_cpu_list) {
+                  if((i_peer.cpu < i_info.cpu) &&
+                      (i_peer.package == i_info.package) &&
+                      (i_peer.core == i_info.core)) {
+                      i_info.sibling++;
+                  }
+              }
+          }
+          std::sort(m_cpu_list.begin(), m_cpu_list.end(), [](const cpu_info& lhs, const cpu_info& rhs) noexcept {
+              if(lhs.node != rhs.node) {
+                  return lhs.node < rhs.node;
+              }
+              if(lhs.sibling != rhs.sibling) {
+                  return lhs.sibling < rhs.sibling;
+              }
+              return lhs.cpu < rhs.cpu;
+          });
+  }
+
+  static  const topology& get_default() noexcept {
+          static topology s_topology;
+          return s_topology;
+  }
+
+  /* get_cpu()
+     <index>th cpu in rank order, wrapping around; with a <node>, only the cpus of that node are counted
+  */
+  inline  int   get_cpu(int index, int node = -1) const noexcept {
+          int l_count = get_cpu_count(node);
+          if(l_count > 0) {
+              int l_index = index % l_count;
+              for(auto& i_info : m_cpu_list) {
+                  if((node < 0) || (i_info.node == node)) {
+                      if(l_index == 0) {
+                          return i_info.cpu;
+                      }
+                      --l_index;
+                  }
+              }
+          }
+          return -1;
+  }
+
+  inline  int   get_cpu_count(int node = -1) const noexcept {
+          if(node >= 0) {
+              return static_cast<int>(std::count_if(m_cpu_list.begin(), m_cpu_list.end(), [node](const cpu_info& info) noexcept {
+                  return info.node == node;
+              }));
+          }
+          return static_cast<int>(m_cpu_list.size());
+  }
+
+  inline  bool  get_node_set(int node, cpu_set_t& set) const noexcept {
+          CPU_ZERO(std::addressof(set));
+          for(auto& i_info : m_cpu_list) {
+              if(i_info.node == node) {
+                  CPU_SET(i_info.cpu, std::addressof(set));
+              }
+          }
+          return CPU_COUNT(std::addressof(set)) > 0;
+  }
+
+  /* get_node()
+     <index>th node that has cpus, wrapping around; nodes without cpus are skipped
+  */
+  inline  int   get_node(int index) const noexcept {
+          int l_count = 0;
+          for(int i_node = 0; i_node < m_node_count; i_node++) {
+              if(get_cpu_count(i_node) > 0) {
+                  ++l_count;
+              }
+          }
+          if(l_count > 0) {
+              int l_index = index % l_count;
+              for(int i_node = 0; i_node < m_node_count; i_node++) {
+                  if(get_cpu_count(i_node) > 0) {
+                      if(l_index == 0) {
+                          return i_node;
+                      }
+                      --l_index;
+                  }
+              }
+          }
+          return -1;
+  }
+
+  /* get_node_count()
+     one past the highest online node id; ids below it may belong to nodes that are offline or have no cpus
+  */
+  inline  int   get_node_count() const noexcept {
+          return m_node_count;
+  }
+
+  inline  int   get_node_of(int cpu) const noexcept {
+          for(auto& i_info : m_cpu_list) {
+              if(i_info.cpu == cpu) {
+                  return i_info.node;
+              }
+          }
+          return -1;
+  }
+
+  /* get_node_of()
+     NUMA node holding the page at <p>, faulting it in if needed; -1 if unknown
+  */
+  static  int   get_node_of(const void* p) noexcept {
+          int l_node = -1;
+          if(syscall(SYS_get_mempolicy, std::addressof(l_node), nullptr, 0, const_cast<void*>(p), 3 /*MPOL_F_NODE | MPOL_F_ADDR*/) != 0) {
+              return -1;
+          }
+          return l_node;
+  }
+};
+
+/*namespace pxi*/ }
+#endif
@@ -20,89 +20,172 @@
     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **/
 #include "tmp.h"
-#include "mmi.h"
 #include "mmi/pool.h"
 
-// static thread_local mmi::pool<char, map> s_tmp;
-
-//       tmp::tmp() noexcept
-// {
-// }
-
-//       tmp::tmp(const tmp&) noexcept
-// {
-// }
-
-//       tmp::tmp(tmp&&) noexcept
-// {
-// }
-
-// auto  tmp::save() noexcept -> std::size_t
-// {
-//       return s_tmp.save();
-// }
-
-// void  tmp::save(std::size_t& offset) noexcept
-// {
-//       s_tmp.save(offset);
-// }
-
-// char* tmp::ptr_get(const char* src, std::size_t length) noexcept
-// {
-//       return s_tmp.ptr_get(src, length);
-// }
-
-// char* tmp::raw_get(std::size_t count) noexcept
-// {
-//       return s_tmp.raw_get(count);
-// }
-
-// char* tmp::ptr_fmt(const char* fmt, ...) noexcept
-// {
-//       char*   l_result;
-//       va_list l_va;
-//       va_start(l_va, fmt);
-//       l_result = ptr_fmt_v(fmt, l_va);
-//       va_end(l_va);
-//       return  l_result;
-// }
-
-// char* tmp::ptr_fmt_v(const char* fmt, va_list va) noexcept
-// {
-//       return s_tmp.ptr_fmt_v(fmt, va);
-// }
-
-// char* tmp::raw_unget(std::size_t count) noexcept
-// {
-//       return s_tmp.raw_unget(count);
-// }
-
-// char* tmp::ptr_unget(std::size_t count) noexcept
-// {
-//       return s_tmp.ptr_unget(count);
-// }
-
-// auto  tmp::get_length(std::size_t offset) noexcept
-// {
-//       return s_tmp.get_length(offset);
-// }
-
-// char* tmp::restore(std::size_t offset) noexcept
-// {
-//       return s_tmp.restore(offset);
-// }
-
-// bool  tmp::reserve(std::size_t count) noexcept
-// {
-//       return s_tmp.reserve(count);
-// }
-
-// tmp&  tmp::operator=(const tmp&) noexcept
-// {
-//       return *this;
-// }
-
-// tmp&  tmp::operator=(tmp&&) noexcept
-// {
-//       return *this;
-// }
+static thread_local mmi::pool<char, map> s_tmp;
+
+/* get_tmp()
+   scratch arena of the calling thread, reserved on first use
+*/
+static mmi::pool<char, map>& get_tmp() noexcept
+{
+      if(s_tmp.get_base() == nullptr) {
+          s_tmp.reserve(tmp::reserve_size);
+      }
+      return s_tmp;
+}
+
+auto  tmp::save() noexcept -> std::size_t
+{
+      return s_tmp.get_used_size();
+}
+
+void  tmp::save(std::size_t& offset) noexcept
+{
+      offset = save();
+}
+
+/* ptr_get()
+   copy <length> characters of <src> (the whole string if <length> is 0) into the arena, zero terminated
+*/
+char* tmp::ptr_get(const char* src, std::size_t length) noexcept
+{
+      if(src != nullptr) {
+          if(length == 0) {
+              length = std::strlen(src);
+          }
+          char* p_raw = get_tmp().get(length);
+          if(p_raw != nullptr) {
+              std::memcpy(p_raw, src, length);
+          }
+          return p_raw;
+      }
+      return nullptr;
+}
+
+char* tmp::raw_get(std::size_t size, std::size_t align) noexcept
+{
+      return get_tmp().raw_get(size, align);
+}
+
+char* tmp::ptr_fmt(const char* format, ...) noexcept
+{
+      char*   l_result;
+      va_list l_va;
+      va_start(l_va, format);
+      l_result = ptr_fmt_v(format, l_va);
+      va_end(l_va);
+      return  l_result;
+}
+
+char* tmp::ptr_fmt_v(const char* format, va_list va) noexcept
+{
+      auto& l_tmp = get_tmp();
+      char* p_raw = l_tmp.fvacquire(format, va);
+      if(p_raw != nullptr) {
+          l_tmp.commit();
+      }
+      return p_raw;
+}
+
+/* get_length()
+   number of bytes taken from the arena since <offset> was saved
+*/
+auto  tmp::get_length(std::size_t offset) noexcept -> std::size_t
+{
+      std::size_t l_used = s_tmp.get_used_size();
+      if(l_used > offset) {
+          return l_used - offset;
+      }
+      return 0;
+}
+
+bool  tmp::has_ptr(const void* p) noexcept
+{
+      const char* l_base = s_tmp.get_base();
+      const char* l_ptr  = reinterpret_cast<const char*>(p);
+      if(l_base != nullptr) {
+          return (l_ptr >= l_base) && (l_ptr < l_base + s_tmp.get_size());
+      }
+      return false;
+}
+
+/* restore()
+   release everything allocated from the arena after <offset> was saved
+*/
+char* tmp::restore(std::size_t offset) noexcept
+{
+      const char* l_base = s_tmp.get_base();
+      if(l_base != nullptr) {
+          if(offset <= s_tmp.get_used_size()) {
+              const char* l_position = l_base + offset;
+              s_tmp.restore(l_position);
+              return s_tmp.get_base() + offset;
+          }
+      }
+      return nullptr;
+}
+
+/* reserve()
+   set the size of the arena of the calling thread; the arena can only grow while it is empty
+*/
+bool  tmp::reserve(std::size_t size) noexcept
+{
+      return s_tmp.reserve(size);
+}
+
+      tmp::resource::resource(::resource* upstream) noexcept:
+      ::resource(),
+      m_upstream(upstream),
+      m_offset(tmp::save())
+{
+      if(m_upstream == nullptr) {
+          m_upstream = ::resource::get_default();
+      }
+}
+
+      tmp::resource::~resource()
+{
+      tmp::restore(m_offset);
+}
+
+void* tmp::resource::do_allocate(std::size_t size, std::size_t align) noexcept
+{
+      if(char* p_raw = tmp::raw_get(size, align); p_raw != nullptr) {
+          return p_raw;
+      }
+      return m_upstream->allocate(size, align);
+}
+
+void  tmp::resource::do_deallocate(void* p, std::size_t size, std::size_t align) noexcept
+{
+      if(tmp::has_ptr(p)) {
+          // only the last block can be given back to the arena, the rest is released on destruction
+          std::size_t l_offset = reinterpret_cast<char*>(p) - s_tmp.get_base();
+          if((l_offset >= m_offset) &&
+              (l_offset + size == s_tmp.get_used_size())) {
+              tmp::restore(l_offset);
+          }
+      } else
+          m_upstream->deallocate(p, size, align);
+}
+
+bool  tmp::resource::do_is_equal(const std::pmr::memory_resource& rhs) const noexcept
+{
+      return std::addressof(rhs) == this;
+}
+
+std::size_t tmp::resource::get_fixed_size() const noexcept
+{
+      return 0;
+}
+
+bool  tmp::resource::has_variable_size() const noexcept
+{
+      return true;
+}
+
+std::size_t tmp::resource::get_alloc_size(std::size_t size) const noexcept
+{
+      return size;
+}
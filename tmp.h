@@ -22,31 +22,99 @@
     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **/
 #include <global.h>
-#include <sys.h>
-#include <sys/ios/bio.h>
-
-// class tmp
-// {
-//   public:
-//           tmp() noexcept;
-//           tmp(const tmp&) noexcept;
-//           tmp(tmp&&) noexcept;
-
-//   static  auto  save() noexcept -> std::size_t;
-//   static  void  save(std::size_t& offset) noexcept;
-
-//   static  char* ptr_get(const char*, std::size_t = 0) noexcept;
-//   static  char* raw_get(std::size_t) noexcept;
-//   static  char* ptr_fmt(const char*, ...) noexcept;
-//   static  char* ptr_fmt_v(const char*, va_list) noexcept;
-//   static  char* raw_unget(std::size_t) noexcept;
-//   static  char* ptr_unget(std::size_t) noexcept;
-
-//   static  auto  get_length(std::size_t) noexcept;
-//   static  char* restore(std::size_t) noexcept;
-//   static  bool  reserve(std::size_t) noexcept;
-
-//           tmp&  operator=(const tmp&) noexcept;
-//           tmp&  operator=(tmp&&) noexcept;
-// };
+#include <mmi.h>
+#include <cstdarg>
+
+/* tmp
+   per-thread scratch arena for short lived strings and buffers;
+   allocations are carved from a thread local buffer by bumping a pointer, and are released all at once by restoring an
+   offset previously obtained with save(); use tmp::scope to release them automatically at the end of a block, and
+   tmp::resource to hand the arena to containers that take a std::pmr::memory_resource
+*/
+class tmp
+{
+  public:
+  static  constexpr std::size_t reserve_size = 1024u * 1024u;
+
+  class scope;
+  class resource;
+
+  public:
+          tmp() noexcept = delete;
+          tmp(const tmp&) noexcept = delete;
+          tmp(tmp&&) noexcept = delete;
+
+  static  auto  save() noexcept -> std::size_t;
+  static  void  save(std::size_t& offset) noexcept;
+
+  static  char* ptr_get(const char*, std::size_t = 0) noexcept;
+  static  char* raw_get(std::size_t, std::size_t = alignof(max_align_t)) noexcept;
+  static  char* ptr_fmt(const char*, ...) noexcept;
+  static  char* ptr_fmt_v(const char*, va_list) noexcept;
+
+  static  auto  get_length(std::size_t) noexcept -> std::size_t;
+  static  bool  has_ptr(const void*) noexcept;
+  static  char* restore(std::size_t) noexcept;
+  static  bool  reserve(std::size_t) noexcept;
+
+          tmp&  operator=(const tmp&) noexcept = delete;
+          tmp&  operator=(tmp&&) noexcept = delete;
+};
+
+/* tmp::scope
+   releases everything allocated from the scratch arena of the calling thread during its lifetime
+*/
+class tmp::scope
+{
+  std::size_t   m_offset;
+
+  public:
+  inline  scope() noexcept:
+          m_offset(tmp::save()) {
+  }
+
+          scope(const scope&) noexcept = delete;
+          scope(scope&&) noexcept = delete;
+
+  inline  ~scope() {
+          tmp::restore(m_offset);
+  }
+
+  inline  std::size_t get_length() const noexcept {
+          return tmp::get_length(m_offset);
+  }
+
+          scope& operator=(const scope&) noexcept = delete;
+          scope& operator=(scope&&) noexcept = delete;
+};
+
+/* tmp::resource
+   memory resource drawing from the scratch arena of the calling thread; deallocation is a no-op, except for the last
+   block which is given back so that growing containers can reuse it. Requests that don't fit in the arena are passed
+   to the <upstream> resource. Everything taken from the arena is released when the object is destroyed, so it must
+   not outlive the containers using it and must stay on the thread that created it.
+*/
+class tmp::resource: public ::resource
+{
+  ::resource*   m_upstream;
+  std::size_t   m_offset;
+
+  protected:
+  virtual void*  do_allocate(std::size_t, std::size_t) noexcept override;
+  virtual void   do_deallocate(void*, std::size_t, std::size_t) noexcept override;
+  virtual bool   do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+
+  public:
+          resource(::resource* = nullptr) noexcept;
+          resource(const resource&) noexcept = delete;
+          resource(resource&&) noexcept = delete;
+  virtual ~resource();
+
+  virtual std::size_t get_fixed_size() const noexcept override;
+  virtual bool        has_variable_size() const noexcept override;
+  virtual std::size_t get_alloc_size(std::size_t) const noexcept override;
+
+          resource& operator=(const resource&) noexcept = delete;
+          resource& operator=(resource&&) noexcept = delete;
+};
 #endif